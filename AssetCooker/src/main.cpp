@@ -0,0 +1,223 @@
+// Cooks the textures and meshes of a source directory into the files the engine uploads without
+// converting them: .ktx2 textures with a BC1 or BC3 mip chain and .mesh files optimized for the
+// vertex cache and vertex fetch. The ACMR of every mesh is reported before and after.
+//
+//   assetcooker <source dir> <output dir>
+//   assetcooker --pack <pack file> <dir>...
+//
+// Assets keep their relative path with the extension of the cooked format. The content hash of
+// every cooked asset is recorded in the output directory, unchanged assets are skipped.
+//
+// The second form writes the files of the directories into an AssetPack, named by their path
+// relative to the parent of their directory, e.g. shaders/basic.vert.spv.
+
+#include <filesystem>
+#include <iomanip>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <unordered_map>
+
+#include "ToyEngine/Core/AssetPack.hpp"
+#include "ToyEngine/Core/JobSystem.hpp"
+#include "ToyEngine/Renderer/Mesh.hpp"
+#include "ToyEngine/Renderer/MeshOptimizer.hpp"
+#include "ToyEngine/Renderer/Texture.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+// bumped whenever the cooked formats or their settings change, every asset is cooked again
+constexpr uint64_t COOKER_VERSION = 2;
+constexpr const char* MANIFEST_NAME = "manifest.txt";
+
+enum class AssetType { Texture, Mesh };
+
+struct Asset {
+  std::string name;  // source path relative to the source directory
+  fs::path source;
+  fs::path output;
+  AssetType type;
+  uint64_t hash = 0;
+  bool failed = false;
+};
+
+std::optional<AssetType> getAssetType(const fs::path& path) {
+  auto extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" ||
+      extension == ".bmp") {
+    return AssetType::Texture;
+  }
+  if (extension == ".obj") {
+    return AssetType::Mesh;
+  }
+  return std::nullopt;
+}
+
+// FNV-1a over the file content, seeded with the cooker version
+uint64_t hashFile(const fs::path& path) {
+  std::ifstream file(path, std::ios::ate | std::ios::binary);
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to open " + path.string());
+  }
+  std::vector<char> bytes(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(bytes.data(), bytes.size());
+
+  uint64_t hash = 0xcbf29ce484222325 ^ COOKER_VERSION;
+  for (char byte : bytes) {
+    hash = (hash ^ static_cast<uint8_t>(byte)) * 0x100000001b3;
+  }
+  return hash;
+}
+
+// one "<hash> <name>" line per cooked asset
+std::unordered_map<std::string, uint64_t> readManifest(const fs::path& path) {
+  std::unordered_map<std::string, uint64_t> manifest;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream stream{line};
+    uint64_t hash;
+    std::string name;
+    if (stream >> std::hex >> hash && stream.get() == ' ' && std::getline(stream, name)) {
+      manifest[name] = hash;
+    }
+  }
+  return manifest;
+}
+
+void writeManifest(const fs::path& path,
+                   const std::unordered_map<std::string, uint64_t>& manifest) {
+  // an interrupted run keeps the previous manifest
+  fs::path tmp_path = path.string() + ".tmp";
+  std::ofstream file(tmp_path, std::ios::trunc);
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to write " + tmp_path.string());
+  }
+  for (auto& [name, hash] : manifest) {
+    file << std::hex << std::setw(16) << std::setfill('0') << hash << ' ' << name << '\n';
+  }
+  file.close();
+  fs::rename(tmp_path, path);
+}
+
+void cook(const Asset& asset) {
+  fs::create_directories(asset.output.parent_path());
+  switch (asset.type) {
+    case AssetType::Texture: {
+      auto texture = TE::TextureData::load(asset.source.string());
+      texture.generateMips();
+      texture.compress().save(asset.output.string());
+      break;
+    }
+    case AssetType::Mesh: {
+      auto mesh = TE::MeshData::importObj(asset.source.string());
+      auto indices = mesh.getIndices32();
+      float acmr = TE::computeAcmr(indices, mesh.vertices.size());
+      mesh.optimize();
+      indices = mesh.getIndices32();
+      LOG(asset.name << ": " << mesh.vertices.size() << " vertices, " << indices.size() / 3
+                     << " triangles, " << mesh.getIndexSize() * 8 << "-bit indices, ACMR "
+                     << acmr << " -> " << TE::computeAcmr(indices, mesh.vertices.size()));
+      mesh.save(asset.output.string());
+      break;
+    }
+  }
+}
+
+int pack(const fs::path& pack_path, std::span<char*> dirs) {
+  std::vector<TE::AssetPack::Source> sources;
+  for (fs::path dir : dirs) {
+    dir = dir.lexically_normal();
+    if (!dir.has_filename()) {
+      dir = dir.parent_path();  // trailing separator
+    }
+    for (auto& entry : fs::recursive_directory_iterator(dir)) {
+      if (entry.is_regular_file() && entry.path().filename() != MANIFEST_NAME) {
+        sources.push_back({
+            .name = entry.path().lexically_relative(dir.parent_path()).generic_string(),
+            .path = entry.path().string(),
+        });
+      }
+    }
+  }
+
+  TE::AssetPack::write(pack_path.string(), sources);
+  LOG("Packed " << sources.size() << " files into " << pack_path.string());
+  return 0;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc >= 3 && std::string_view{argv[1]} == "--pack") {
+    return pack(argv[2], {argv + 3, argv + argc});
+  }
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " <source dir> <output dir>" << std::endl;
+    std::cerr << "       " << argv[0] << " --pack <pack file> <dir>..." << std::endl;
+    return 2;
+  }
+  fs::path source_dir = argv[1];
+  fs::path output_dir = argv[2];
+  fs::create_directories(output_dir);
+
+  fs::path manifest_path = output_dir / MANIFEST_NAME;
+  auto previous = readManifest(manifest_path);
+
+  std::vector<Asset> assets;
+  for (auto& entry : fs::recursive_directory_iterator(source_dir)) {
+    auto type = entry.is_regular_file() ? getAssetType(entry.path()) : std::nullopt;
+    if (!type) {
+      continue;
+    }
+    fs::path relative = entry.path().lexically_relative(source_dir);
+    fs::path output = output_dir / relative;
+    output.replace_extension(*type == AssetType::Texture ? ".ktx2" : ".mesh");
+    assets.push_back({
+        .name = relative.generic_string(),
+        .source = entry.path(),
+        .output = output,
+        .type = *type,
+    });
+  }
+
+  std::vector<Asset*> dirty;
+  for (auto& asset : assets) {
+    asset.hash = hashFile(asset.source);
+    auto cooked = previous.find(asset.name);
+    if (cooked == previous.end() || cooked->second != asset.hash || !fs::exists(asset.output)) {
+      dirty.push_back(&asset);
+    }
+  }
+
+  TE::JobSystem jobs;
+  jobs.parallelFor(dirty.size(), 1, [&](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; i++) {
+      try {
+        cook(*dirty[i]);
+      } catch (const std::exception& e) {
+        dirty[i]->failed = true;
+        std::cerr << "Failed to cook " << dirty[i]->name << ": " << e.what() << std::endl;
+      }
+    }
+  });
+
+  // removed sources drop out of the manifest, failed ones are cooked again next time
+  std::unordered_map<std::string, uint64_t> manifest;
+  size_t failed = 0;
+  for (auto& asset : assets) {
+    if (asset.failed) {
+      failed++;
+    } else {
+      manifest[asset.name] = asset.hash;
+    }
+  }
+  writeManifest(manifest_path, manifest);
+
+  LOG("Cooked " << dirty.size() - failed << " of " << assets.size() << " assets, "
+                << assets.size() - dirty.size() << " up to date, " << failed << " failed");
+  return failed > 0 ? 1 : 0;
+}
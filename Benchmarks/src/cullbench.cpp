@@ -0,0 +1,114 @@
+// Compares the scalar and SIMD frustum tests and the BVH traversal on 100k random boxes.
+
+#include <algorithm>
+#include <chrono>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "ToyEngine/Core/JobSystem.hpp"
+#include "ToyEngine/Renderer/Bvh.hpp"
+#include "ToyEngine/Renderer/FrustumCulling.hpp"
+
+namespace {
+constexpr uint32_t BOX_COUNT = 100'000;
+constexpr uint32_t ITERATIONS = 200;
+constexpr float WORLD_EXTENT = 500.0f;
+constexpr float MOVED_SHARE = 0.01f;
+
+// average milliseconds per call after one warm-up call
+template <typename F>
+double measure(F&& function) {
+  function();
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < ITERATIONS; i++) {
+    function();
+  }
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / ITERATIONS;
+}
+
+size_t countVisible(const std::vector<uint8_t>& visible) {
+  return std::count(visible.begin(), visible.end(), 1);
+}
+
+void report(const char* name, double milliseconds, double baseline, size_t visible) {
+  std::cout << std::left << std::setw(16) << name << std::right << std::fixed
+            << std::setprecision(3) << std::setw(10) << milliseconds << " ms" << std::setw(8)
+            << std::setprecision(2) << baseline / milliseconds << "x" << std::setw(10) << visible
+            << " visible" << std::endl;
+}
+}  // namespace
+
+int main() {
+  std::mt19937 rng{42};
+  std::uniform_real_distribution<float> position{-WORLD_EXTENT, WORLD_EXTENT};
+  std::uniform_real_distribution<float> size{0.5f, 5.0f};
+
+  std::vector<TE::Aabb> boxes(BOX_COUNT);
+  TE::AabbSoA soa;
+  soa.resize(BOX_COUNT);
+  for (uint32_t i = 0; i < BOX_COUNT; i++) {
+    glm::vec3 min{position(rng), position(rng), position(rng)};
+    boxes[i] = {min, min + glm::vec3{size(rng), size(rng), size(rng)}};
+    soa.set(i, boxes[i]);
+  }
+
+  // camera at the origin looking down +z
+  TE::Frustum frustum{glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 400.0f)};
+
+  std::vector<uint8_t> scalar(BOX_COUNT);
+  std::vector<uint8_t> simd(BOX_COUNT);
+  std::vector<uint8_t> bvh_visible;
+  std::vector<uint8_t> parallel_visible;
+
+  double scalar_ms =
+      measure([&] { TE::cullAabbsScalar(frustum, soa, 0, BOX_COUNT, scalar.data()); });
+  double simd_ms = measure([&] { TE::cullAabbsSimd(frustum, soa, 0, BOX_COUNT, simd.data()); });
+
+  TE::Bvh bvh;
+  auto build_start = std::chrono::steady_clock::now();
+  bvh.build(boxes);
+  std::chrono::duration<double, std::milli> build_ms =
+      std::chrono::steady_clock::now() - build_start;
+  double bvh_ms = measure([&] { bvh.cull(frustum, bvh_visible); });
+  TE::JobSystem jobs;
+  double parallel_ms = measure([&] { bvh.cull(frustum, parallel_visible, &jobs); });
+
+  // move a share of the boxes and refit
+  std::uniform_int_distribution<uint32_t> pick{0, BOX_COUNT - 1};
+  uint32_t moved_count = BOX_COUNT * MOVED_SHARE;
+  double refit_ms = measure([&] {
+    for (uint32_t i = 0; i < moved_count; i++) {
+      uint32_t box = pick(rng);
+      glm::vec3 offset{size(rng) - 2.75f, size(rng) - 2.75f, size(rng) - 2.75f};
+      boxes[box] = {boxes[box].min + offset, boxes[box].max + offset};
+      soa.set(box, boxes[box]);
+      bvh.update(box, boxes[box]);
+    }
+    bvh.refit();
+  });
+
+  // the boxes have moved, compare all paths on the final state
+  TE::cullAabbsScalar(frustum, soa, 0, BOX_COUNT, scalar.data());
+  TE::cullAabbsSimd(frustum, soa, 0, BOX_COUNT, simd.data());
+  bvh.cull(frustum, bvh_visible);
+  bvh.cull(frustum, parallel_visible, &jobs);
+
+  std::cout << BOX_COUNT << " boxes, " << ITERATIONS << " iterations, SIMD: "
+            << TE::getCullingSimdName() << ", " << jobs.getThreadCount() << " threads"
+            << std::endl;
+  report("scalar", scalar_ms, scalar_ms, countVisible(scalar));
+  report("simd", simd_ms, scalar_ms, countVisible(simd));
+  report("bvh", bvh_ms, scalar_ms, countVisible(bvh_visible));
+  report("bvh parallel", parallel_ms, scalar_ms, countVisible(parallel_visible));
+  std::cout << std::setprecision(3) << "bvh build " << build_ms.count() << " ms, refit of "
+            << moved_count << " moved boxes " << refit_ms << " ms" << std::endl;
+
+  if (scalar != simd || scalar != bvh_visible || scalar != parallel_visible) {
+    std::cerr << "culling results differ" << std::endl;
+    return 1;
+  }
+  return 0;
+}
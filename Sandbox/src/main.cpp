@@ -1,3 +1,6 @@
+#include <cstdlib>
+#include <filesystem>
+
 #include <ToyEngine.hpp>
 #include <ToyEngine/Core/EntryPoint.hpp>
 
@@ -5,24 +8,43 @@
 #include "ToyEngine/Core/KeyCodes.hpp"
 #include "ToyEngine/Core/Layer.hpp"
 #include "ToyEngine/Core/Timestep.hpp"
+#include "ToyEngine/Core/Vfs.hpp"
 #include "ToyEngine/ImGui/ImGuiLayer.hpp"
+#include "ToyEngine/Renderer/Mesh.hpp"
 #include "ToyEngine/Renderer/Scene.hpp"
-#include "ToyEngine/Renderer/Texture.hpp"
-#include "ToyEngine/Renderer/VertexArray.hpp"
+#include "ToyEngine/Renderer/TextureStreamer.hpp"
 
 class MainLayer : public TE::Layer {
  public:
   MainLayer() : Layer("Main") {
-    textures.emplace_back("assets/textures/Mona_Lisa.png", 0);
-
-    scene.add(
-        std::vector<TE::VertexArray::VertexType>{
-            {{0.5, -0.5, 0.0}, {1.0, 0.0}},
-            {{0.5, 0.5, 0.0}, {1.0, 0.5}},
-            {{-0.5, 0.5, 0.0}, {0.0, 0.5}},
-            {{-0.5, -0.5, 0.0}, {0.0, 0.0}},
-        },
-        std::vector<uint16_t>{0, 1, 2, 2, 3, 0});
+    // shows a placeholder until the image has been decoded and uploaded in the background
+    TE::TextureHandle texture = textures.request("cooked/textures/Mona_Lisa.ktx2");
+
+    // cooked from assets/ by the assetcooker target
+    auto mesh = TE::MeshData::load("cooked/meshes/quad.mesh");
+    auto& vertices = mesh.vertices;
+    auto indices = mesh.getIndices32();
+
+    quad = scene.add(vertices, indices);
+    scene.setTexture(quad, texture);
+
+    // follows the rotating quad through the transform hierarchy
+    TE::Entity moon = scene.add(vertices, indices);
+    scene.setTexture(moon, texture);
+    scene.setParent(moon, scene.getNode(quad));
+    glm::mat4 moon_transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.8f, 0.0f, 0.0f));
+    scene.setTransform(moon, glm::scale(moon_transform, glm::vec3(0.3f)));
+
+    // a wall of small quads behind the rotating one, drawn with a single instanced draw
+    uint32_t wall = scene.addInstanced(vertices, indices);
+    scene.setInstanceTexture(wall, texture);
+    for (int y = -WALL_SIZE / 2; y < WALL_SIZE / 2; y++) {
+      for (int x = -WALL_SIZE / 2; x < WALL_SIZE / 2; x++) {
+        glm::vec3 position{x * 0.25f, y * 0.25f, 2.0f};
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), position);
+        scene.addInstance(wall, glm::scale(transform, glm::vec3(0.2f)));
+      }
+    }
   }
 
   void onUpdate(TE::Timestep dt) {
@@ -40,24 +62,84 @@ class MainLayer : public TE::Layer {
     }
 
     world = glm::rotate(world, dt * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    scene.ubo.write(&world, sizeof(glm::mat4), 0);
+    scene.setTransform(quad, world);
+    textures.update();
     scene.draw();
   }
 
+  inline const TE::Scene& getScene() const { return scene; }
+
  private:
+  static constexpr int WALL_SIZE = 64;
+
+  TE::TextureStreamer textures;
   TE::Scene scene;
-  std::vector<TE::Texture> textures;
+  TE::Entity quad;
   glm::mat4 world = glm::mat4(1.0f);
 };
 
+// Renders a fixed number of frames and reports the frame throughput and the draw count from
+// which the scene records in parallel, as measured during the run (headless mode only).
+class BenchmarkLayer : public TE::Layer {
+ public:
+  BenchmarkLayer(uint32_t frames, const TE::Scene& scene)
+      : Layer("Benchmark"), frames(frames), scene(scene) {}
+
+  void onUpdate(TE::Timestep dt) {
+    if (frame++ > 0) {  // skip the first frame as it includes startup costs
+      elapsed += dt;
+    }
+
+    if (frame == frames) {
+      LOG("Rendered " << frames << " frames in " << elapsed << "s ("
+                      << (frames - 1) / elapsed << " frames/s)");
+      uint32_t parallel_draws = scene.getParallelDraws();
+      if (parallel_draws == UINT32_MAX) {
+        LOG("Parallel recording threshold not measured");
+      } else {
+        LOG("Parallel recording from " << parallel_draws << " draw items");
+      }
+      TE::Application::get().close();
+    }
+  }
+
+ private:
+  uint32_t frames;
+  const TE::Scene& scene;
+  uint32_t frame = 0;
+  float elapsed = 0.0f;
+};
+
+// Set TE_HEADLESS=<frames> to render offscreen without a window, e.g. on CI machines.
+static const char* headlessFrames() { return std::getenv("TE_HEADLESS"); }
+// Set TE_RENDER_THREAD to record and present the frames on a separate thread.
+static bool renderThread() { return std::getenv("TE_RENDER_THREAD") != nullptr; }
+
 class Sandbox : public TE::Application {
  public:
-  Sandbox() {
-    pushLayer(new MainLayer());
-    pushLayer(new TE::ImGuiLayer());
+  Sandbox()
+      : Application(TE::WindowProps("ToyEngine", 1280, 720, headlessFrames() != nullptr),
+                    renderThread()) {
+    auto* main_layer = new MainLayer();
+    pushLayer(main_layer);
+    if (getWindow().isHeadless()) {
+      pushLayer(
+          new BenchmarkLayer(std::max(2, std::atoi(headlessFrames())), main_layer->getScene()));
+    } else {
+      pushLayer(new TE::ImGuiLayer());
+    }
   }
 
   ~Sandbox() {}
 };
 
-std::unique_ptr<TE::Application> TE::createApplication() { return std::make_unique<Sandbox>(); }
\ No newline at end of file
+std::unique_ptr<TE::Application> TE::createApplication() {
+  // the shaders and cooked assets, the loose copies next to it override them in debug builds
+  if (std::filesystem::exists("assets.pack")) {
+    TE::Vfs::get().mount("assets.pack");
+#ifdef NDEBUG
+    TE::Vfs::get().setLooseFiles(false);
+#endif
+  }
+  return std::make_unique<Sandbox>();
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : enable
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 uv;
+
+layout(location = 0) out vec2 outUV;
+layout(location = 1) flat out uint outTexture;
+
+// rows of the batch's affine transforms, one array of stride elements per row
+layout(binding = 1) readonly buffer Instances {
+    vec4 rows[];
+} instances[];
+
+layout(push_constant) uniform InstanceParameters {
+    mat4 viewProjection;
+    uint instances;
+    uint first;
+    uint stride;
+    uint texture;
+} instanceParams;
+
+void main() {
+    uint instance = instanceParams.first + gl_InstanceIndex;
+    uint rows = instanceParams.instances;
+    vec4 local = vec4(position, 1.0);
+    vec4 world = vec4(
+        dot(instances[rows].rows[instance], local),
+        dot(instances[rows].rows[instance + instanceParams.stride], local),
+        dot(instances[rows].rows[instance + 2 * instanceParams.stride], local),
+        1.0);
+    gl_Position = instanceParams.viewProjection * world;
+    outUV = uv;
+    outTexture = instanceParams.texture;
+}
@@ -1,11 +1,13 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : enable
 
 layout(binding = 2) uniform sampler2D texSampler[];
 
 layout(location = 0) in vec2 uv;
+layout(location = 1) flat in uint textureIndex;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(texSampler[0], uv);
-}
\ No newline at end of file
+    outColor = texture(texSampler[nonuniformEXT(textureIndex)], uv);
+}
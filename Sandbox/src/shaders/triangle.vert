@@ -5,17 +5,33 @@ layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 uv;
 
 layout(location = 0) out vec2 outUV;
+layout(location = 1) flat out uint outTexture;
 
-layout(binding = 0) uniform UBO {
-    mat4 world;
-} ubos[];
+struct DrawData {
+    uint world;
+    uint texture;
+};
+
+layout(binding = 1) readonly buffer Transforms {
+    mat4 worlds[];
+} transforms[];
+
+// written by the CPU or by cull.comp
+layout(binding = 1) readonly buffer Draws {
+    DrawData draws[];
+} draws[];
 
 layout(push_constant) uniform DrawParameters {
     mat4 viewProjection;
-    int world;
+    uint transforms;
+    uint drawBuffer;
+    uint draws;
 } drawParams;
 
 void main() {
-    gl_Position = drawParams.viewProjection * ubos[drawParams.world].world * vec4(position, 1.0);
+    DrawData draw = draws[drawParams.drawBuffer].draws[drawParams.draws + gl_InstanceIndex];
+    mat4 world = transforms[drawParams.transforms].worlds[draw.world];
+    gl_Position = drawParams.viewProjection * world * vec4(position, 1.0);
     outUV = uv;
-}
\ No newline at end of file
+    outTexture = draw.texture;
+}
@@ -1,5 +1,7 @@
 #include "Application.hpp"
 
+#include <chrono>
+
 #include "ToyEngine/Core/Input.hpp"
 #include "ToyEngine/Core/Timestep.hpp"
 #include "ToyEngine/Core/Window.hpp"
@@ -9,29 +11,62 @@ namespace TE {
 
 Application* Application::instance = nullptr;
 
-Application::Application() {
+Application::Application(const WindowProps& props, bool render_thread)
+    : use_render_thread{render_thread} {
   instance = this;
-  window = Window::create();
+  window = Window::create(props);
   window->setEventCallback(BIND_EVENT_FN(onEvent));
   Input::init(window->getNativeWindow());
 }
 
-Application::~Application() { GraphicsContext::get().getDevice().waitIdle(); }
+Application::~Application() {
+  render_thread.reset();
+  GraphicsContext::get().getDevice().waitIdle();
+}
 
 void Application::run() {
+  // started here, so the layers' setup before the first frame has the GPU to itself
+  if (use_render_thread) {
+    render_thread = std::make_unique<RenderThread>();
+  }
+
+  auto start_time = std::chrono::steady_clock::now();
   while (running) {
-    Timestep time = glfwGetTime();
+    // glfw's timer is unavailable without a window
+    Timestep time =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
     Timestep delta_time = time - lastFrameTime;
     lastFrameTime = time;
 
     window->onUpdate();
 
+    if (render_thread) {
+      packet = &render_thread->beginPacket();
+      for (auto layer : layerStack) {
+        layer->onUpdate(delta_time);
+      }
+      packet = nullptr;
+      render_thread->publish();
+      continue;
+    }
+
     GraphicsContext::get().beginFrame();
     for (auto layer : layerStack) {
       layer->onUpdate(delta_time);
     }
     GraphicsContext::get().endFrame();
   }
+
+  // renders the frames still queued
+  render_thread.reset();
+}
+
+void Application::submit(std::function<void()> command) {
+  if (packet) {
+    packet->submit(std::move(command));
+  } else {
+    command();
+  }
 }
 
 void Application::onEvent(Event& e) {
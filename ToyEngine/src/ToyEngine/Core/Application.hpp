@@ -2,9 +2,11 @@
 
 #include "Layer.hpp"
 #include "LayerStack.hpp"
+#include "ToyEngine/Core/JobSystem.hpp"
 #include "ToyEngine/Core/Timestep.hpp"
 #include "ToyEngine/Events/Event.hpp"
 #include "ToyEngine/Events/WindowEvent.hpp"
+#include "ToyEngine/Renderer/RenderThread.hpp"
 #include "Window.hpp"
 #include "tepch.hpp"
 
@@ -12,25 +14,39 @@ namespace TE {
 
 class Application {
  public:
-  Application();
+  // With a render thread the layers' render commands of a frame are recorded and submitted while
+  // the next frame is simulated.
+  Application(const WindowProps& props = WindowProps(), bool render_thread = false);
   virtual ~Application();
 
   void run();
   void onEvent(Event& e);
   void pushLayer(Layer* layer);
   void pushOverlay(Layer* layer);
+  inline void close() { running = false; }
+  // Queues a render command of the frame being updated. It runs on the render thread if there is
+  // one, otherwise right away, so it must only read data it captured by value or that the
+  // simulation doesn't touch.
+  void submit(std::function<void()> command);
 
   inline Window& getWindow() { return *window; }
+  // shared by the engine and the layers, the main thread is its thread 0
+  inline JobSystem& getJobSystem() { return jobs; }
   inline static Application& get() { return *instance; }
 
  private:
   bool onWindowClose(WindowCloseEvent& e);
 
+  JobSystem jobs;
   std::unique_ptr<Window> window;
   LayerStack layerStack;
   bool running = true;
   Timestep lastFrameTime = 0.0f;
 
+  bool use_render_thread;
+  std::unique_ptr<RenderThread> render_thread;
+  RenderPacket* packet = nullptr;  // of the frame being updated
+
   static Application* instance;
 };
 
@@ -0,0 +1,124 @@
+#include "AssetPack.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+
+namespace TE {
+namespace {
+constexpr char MAGIC[4] = {'T', 'E', 'P', 'K'};
+constexpr uint32_t VERSION = 1;
+constexpr uint64_t FILE_ALIGNMENT = 16;
+
+struct PackHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t entry_count;
+  uint32_t names_size;
+};
+
+uint64_t alignUp(uint64_t value) {
+  return (value + FILE_ALIGNMENT - 1) / FILE_ALIGNMENT * FILE_ALIGNMENT;
+}
+}  // namespace
+
+AssetPack::AssetPack(const std::string& path) : file{path} {
+  auto bytes = file.getBytes();
+
+  PackHeader header;
+  if (bytes.size() < sizeof(header)) {
+    throw std::runtime_error("Invalid asset pack " + path);
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  size_t names_offset = sizeof(header) + size_t{header.entry_count} * sizeof(Entry);
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+      bytes.size() < names_offset + header.names_size) {
+    throw std::runtime_error("Invalid or outdated asset pack " + path);
+  }
+
+  // the mapping is page aligned and the header keeps the entries aligned
+  entries = {reinterpret_cast<const Entry*>(bytes.data() + sizeof(header)), header.entry_count};
+  names = reinterpret_cast<const char*>(bytes.data() + names_offset);
+  for (auto& entry : entries) {
+    if (uint64_t{entry.name_offset} + entry.name_length > header.names_size ||
+        entry.offset > bytes.size() || bytes.size() - entry.offset < entry.size) {
+      throw std::runtime_error("Invalid asset pack " + path);
+    }
+  }
+}
+
+std::optional<std::span<const uint8_t>> AssetPack::find(std::string_view name) const {
+  auto entry = std::lower_bound(
+      entries.begin(), entries.end(), name,
+      [this](const Entry& entry, std::string_view name) { return getName(entry) < name; });
+  if (entry == entries.end() || getName(*entry) != name) {
+    return std::nullopt;
+  }
+  return file.getBytes().subspan(entry->offset, entry->size);
+}
+
+void AssetPack::write(const std::string& path, std::vector<Source> sources) {
+  std::sort(sources.begin(), sources.end(),
+            [](const Source& a, const Source& b) { return a.name < b.name; });
+  for (size_t i = 1; i < sources.size(); i++) {
+    if (sources[i].name == sources[i - 1].name) {
+      throw std::runtime_error("Duplicate file " + sources[i].name + " in asset pack " + path);
+    }
+  }
+
+  PackHeader header{
+      .magic = {},
+      .version = VERSION,
+      .entry_count = static_cast<uint32_t>(sources.size()),
+      .names_size = 0,
+  };
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+
+  std::vector<Entry> entries(sources.size());
+  for (size_t i = 0; i < sources.size(); i++) {
+    entries[i].name_offset = header.names_size;
+    entries[i].name_length = sources[i].name.size();
+    header.names_size += sources[i].name.size();
+  }
+
+  // write to a temporary file first so a failed write never leaves a truncated pack behind
+  std::string tmp_path = path + ".tmp";
+  std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    throw std::runtime_error("Failed to write asset pack " + tmp_path);
+  }
+
+  // the table of contents is written again once the file offsets are known
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+  for (auto& source : sources) {
+    out.write(source.name.data(), source.name.size());
+  }
+
+  uint64_t offset = sizeof(header) + entries.size() * sizeof(Entry) + header.names_size;
+  for (size_t i = 0; i < sources.size(); i++) {
+    std::ifstream in(sources[i].path, std::ios::ate | std::ios::binary);
+    if (!in.is_open()) {
+      throw std::runtime_error("Failed to open " + sources[i].path);
+    }
+    std::vector<char> bytes(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(bytes.data(), bytes.size());
+
+    uint64_t aligned = alignUp(offset);
+    std::fill_n(std::ostreambuf_iterator<char>(out), aligned - offset, '\0');
+    out.write(bytes.data(), bytes.size());
+    entries[i].offset = aligned;
+    entries[i].size = bytes.size();
+    offset = aligned + bytes.size();
+  }
+
+  out.seekp(sizeof(header));
+  out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+  out.close();
+  if (!out) {
+    throw std::runtime_error("Failed to write asset pack " + tmp_path);
+  }
+  std::filesystem::rename(tmp_path, path);
+}
+}  // namespace TE
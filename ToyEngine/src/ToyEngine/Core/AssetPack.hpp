@@ -0,0 +1,45 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "ToyEngine/Core/MappedFile.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Archive of files looked up by name. A header and a table of contents sorted by name are followed
+// by the names and the file contents, each file aligned to 16 bytes. The pack is mapped into
+// memory, files are returned as views into the mapping.
+class AssetPack {
+ public:
+  struct Source {
+    std::string name;  // name the file is looked up by
+    std::string path;  // file written into the pack
+  };
+
+  AssetPack(const std::string& path);
+
+  // Views stay valid as long as the pack lives. Thread-safe.
+  std::optional<std::span<const uint8_t>> find(std::string_view name) const;
+  inline uint32_t getFileCount() const { return entries.size(); }
+
+  static void write(const std::string& path, std::vector<Source> sources);
+
+ private:
+  struct Entry {
+    uint32_t name_offset;
+    uint32_t name_length;
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  inline std::string_view getName(const Entry& entry) const {
+    return {names + entry.name_offset, entry.name_length};
+  }
+
+  MappedFile file;
+  std::span<const Entry> entries;
+  const char* names = nullptr;
+};
+}  // namespace TE
@@ -13,17 +13,26 @@ void Input::init(GLFWwindow* window) {
 }
 
 bool Input::isKeyPressed(KeyCode keyCode) {
+  if (!Input::window) {
+    return false;
+  }
   auto state = glfwGetKey(Input::window, keyCode);
   return state == GLFW_PRESS || state == GLFW_REPEAT;
 }
 
 bool Input::isMouseButtonPressed(MouseCode button) {
+  if (!Input::window) {
+    return false;
+  }
   auto state = glfwGetMouseButton(Input::window, button);
   return state == GLFW_PRESS;
 }
 
 std::pair<float, float> Input::getMousePosition() {
-  double xpos, ypos;
+  double xpos = 0.0, ypos = 0.0;
+  if (!Input::window) {
+    return {0.0f, 0.0f};
+  }
   glfwGetCursorPos(Input::window, &xpos, &ypos);
   return {static_cast<float>(xpos), static_cast<float>(ypos)};
 }
@@ -6,6 +6,7 @@
 namespace TE {
 class Input {
  public:
+  // window may be nullptr for headless applications, all queries then report no input
   static void init(GLFWwindow* window);
   static bool isKeyPressed(KeyCode keyCode);
   static bool isMouseButtonPressed(MouseCode button);
@@ -0,0 +1,138 @@
+#include "JobSystem.hpp"
+
+#include "tepch.hpp"
+
+namespace TE {
+namespace {
+thread_local uint32_t thread_index = 0;
+}  // namespace
+
+JobSystem::JobSystem(uint32_t thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (uint32_t i = 0; i < thread_count; i++) {
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for (uint32_t i = 1; i < thread_count; i++) {
+    workers.emplace_back([this, i] { workerLoop(i); });
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard lock{sleep_mutex};
+    stopping = true;
+  }
+  sleep_condition.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+uint32_t JobSystem::getThreadIndex() { return thread_index; }
+
+void JobSystem::run(std::function<void()> function, JobCounter* signal, JobCounter* dependency) {
+  if (signal) {
+    signal->value.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (dependency) {
+    std::lock_guard lock{dependency->mutex};
+    if (!dependency->isDone()) {
+      dependency->dependents.push_back({std::move(function), signal});
+      return;
+    }
+  }
+  push({std::move(function), signal});
+}
+
+void JobSystem::wait(JobCounter& counter) {
+  while (!counter.isDone()) {
+    if (auto job = pop()) {
+      execute(*job);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  std::lock_guard lock{counter.mutex};
+}
+
+void JobSystem::push(JobCounter::Job job) {
+  auto& queue = *queues[thread_index < queues.size() ? thread_index : 0];
+  {
+    std::lock_guard lock{queue.mutex};
+    queue.jobs.push_back(std::move(job));
+  }
+  queued.fetch_add(1, std::memory_order_release);
+
+  // a worker checking for jobs either sees the new one or is already waiting for the notify
+  { std::lock_guard lock{sleep_mutex}; }
+  sleep_condition.notify_one();
+}
+
+std::optional<JobCounter::Job> JobSystem::pop() {
+  uint32_t own = thread_index < queues.size() ? thread_index : 0;
+  for (uint32_t i = 0; i < queues.size(); i++) {
+    uint32_t index = (own + i) % queues.size();
+    auto& queue = *queues[index];
+    std::lock_guard lock{queue.mutex};
+    if (queue.jobs.empty()) {
+      continue;
+    }
+
+    // newest own job while its data is still in cache, oldest job of other threads
+    JobCounter::Job job;
+    if (index == own) {
+      job = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+    } else {
+      job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+    }
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+  }
+  return std::nullopt;
+}
+
+void JobSystem::execute(JobCounter::Job& job) {
+  job.function();
+
+  auto* signal = job.signal;
+  if (!signal) {
+    return;
+  }
+
+  // the last job of the counter releases the jobs depending on it, wait() takes the lock before
+  // returning, so the counter isn't destroyed while it's held
+  std::vector<JobCounter::Job> dependents;
+  {
+    std::lock_guard lock{signal->mutex};
+    if (signal->value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      dependents = std::move(signal->dependents);
+      signal->dependents.clear();
+    }
+  }
+  for (auto& dependent : dependents) {
+    push(std::move(dependent));
+  }
+}
+
+void JobSystem::workerLoop(uint32_t index) {
+  thread_index = index;
+  while (true) {
+    if (auto job = pop()) {
+      execute(*job);
+      continue;
+    }
+
+    std::unique_lock lock{sleep_mutex};
+    sleep_condition.wait(lock, [this] { return stopping || queued.load() > 0; });
+    if (stopping) {
+      return;
+    }
+  }
+}
+}  // namespace TE
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "tepch.hpp"
+
+namespace TE {
+class JobSystem;
+
+// Counts the unfinished jobs signalling it. Jobs may depend on a counter, they are queued once it
+// reaches zero.
+class JobCounter {
+ public:
+  inline bool isDone() const { return value.load(std::memory_order_acquire) == 0; }
+
+ private:
+  friend class JobSystem;
+
+  struct Job {
+    std::function<void()> function;
+    JobCounter* signal;
+  };
+
+  std::atomic<uint32_t> value = 0;
+  std::mutex mutex;
+  std::vector<Job> dependents;
+};
+
+// Work-stealing job system. Every thread owns a deque, it pushes and pops its own jobs at the back
+// and idle threads steal from the front of the others. The thread creating the system takes part
+// as thread 0 whenever it waits for jobs, other threads like the render thread share its deque.
+class JobSystem {
+ public:
+  // Zero uses one thread per hardware thread.
+  JobSystem(uint32_t thread_count = 0);
+  ~JobSystem();
+
+  // Increments signal until the job has finished. A job with a dependency is queued once the
+  // dependency's counter reaches zero.
+  void run(std::function<void()> function, JobCounter* signal = nullptr,
+           JobCounter* dependency = nullptr);
+  // Runs queued jobs until the counter reaches zero, afterwards the counter may be destroyed.
+  void wait(JobCounter& counter);
+
+  // Calls function(begin, end) for batches of [0, count) in parallel and waits for all of them.
+  // Zero batch size splits the range into a few batches per thread.
+  template <typename F>
+  void parallelFor(uint32_t count, uint32_t batch_size, F&& function);
+
+  inline uint32_t getThreadCount() const { return queues.size(); }
+  // index of the calling thread, 0 for threads outside of the system
+  static uint32_t getThreadIndex();
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<JobCounter::Job> jobs;
+  };
+
+  void push(JobCounter::Job job);
+  std::optional<JobCounter::Job> pop();
+  void execute(JobCounter::Job& job);
+  void workerLoop(uint32_t index);
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+
+  std::atomic<uint32_t> queued = 0;
+  std::mutex sleep_mutex;
+  std::condition_variable sleep_condition;
+  bool stopping = false;
+};
+
+template <typename F>
+void JobSystem::parallelFor(uint32_t count, uint32_t batch_size, F&& function) {
+  if (count == 0) {
+    return;
+  }
+  if (batch_size == 0) {
+    batch_size = std::max(1u, count / (getThreadCount() * 4));
+  }
+  if (batch_size >= count) {
+    function(0u, count);
+    return;
+  }
+
+  JobCounter counter;
+  for (uint32_t begin = batch_size; begin < count; begin += batch_size) {
+    uint32_t end = std::min(begin + batch_size, count);
+    run([&function, begin, end] { function(begin, end); }, &counter);
+  }
+  // the first batch runs on the calling thread
+  function(0u, batch_size);
+  wait(counter);
+}
+}  // namespace TE
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <span>
+
+#include "tepch.hpp"
+
+namespace TE {
+// Read-only memory mapping of a whole file, pages are read in on first access.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  MappedFile(const std::string& path);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  ~MappedFile();
+
+  inline std::span<const uint8_t> getBytes() const { return {data, size}; }
+
+ private:
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+};
+}  // namespace TE
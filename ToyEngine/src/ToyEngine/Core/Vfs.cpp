@@ -0,0 +1,33 @@
+#include "Vfs.hpp"
+
+#include <filesystem>
+
+namespace TE {
+Vfs& Vfs::get() {
+  static Vfs vfs;
+  return vfs;
+}
+
+void Vfs::mount(const std::string& pack_path) {
+  packs.push_back(std::make_unique<AssetPack>(pack_path));
+  LOG("Mounted " << pack_path << " with " << packs.back()->getFileCount() << " files");
+}
+
+VfsFile Vfs::open(std::string_view path) const {
+  VfsFile file;
+  if (loose_files && std::filesystem::is_regular_file(path)) {
+    file.loose = MappedFile{std::string{path}};
+    file.bytes = file.loose.getBytes();
+    return file;
+  }
+
+  // later packs patch earlier ones
+  for (auto pack = packs.rbegin(); pack != packs.rend(); pack++) {
+    if (auto bytes = (*pack)->find(path)) {
+      file.bytes = *bytes;
+      return file;
+    }
+  }
+  throw std::runtime_error("File not found: " + std::string{path});
+}
+}  // namespace TE
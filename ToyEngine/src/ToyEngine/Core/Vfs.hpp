@@ -0,0 +1,44 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+
+#include "ToyEngine/Core/AssetPack.hpp"
+#include "ToyEngine/Core/MappedFile.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// A file opened through the Vfs. Files from a pack are views into its mapping, loose files are
+// mapped for as long as the object lives.
+class VfsFile {
+ public:
+  inline std::span<const uint8_t> getBytes() const { return bytes; }
+
+ private:
+  friend class Vfs;
+
+  MappedFile loose;
+  std::span<const uint8_t> bytes;
+};
+
+// Looks files up by their path relative to the working directory, first as loose files if they
+// are enabled, then in the mounted packs starting with the last one. Packs are mounted before
+// anything is loaded, afterwards opening files is thread-safe.
+class Vfs {
+ public:
+  static Vfs& get();
+
+  void mount(const std::string& pack_path);
+  // Loose files override the packs during development, disabling them saves a lookup per file.
+  inline void setLooseFiles(bool enabled) { loose_files = enabled; }
+
+  // Throws if the file exists neither loose nor in a pack.
+  VfsFile open(std::string_view path) const;
+
+ private:
+  Vfs() = default;
+
+  std::vector<std::unique_ptr<AssetPack>> packs;
+  bool loose_files = true;
+};
+}  // namespace TE
@@ -13,6 +13,14 @@ std::unique_ptr<Window> Window::create(const WindowProps& props) {
 }
 
 Window::Window(const WindowProps& props) {
+  if (props.Headless) {
+    data.title = props.Title;
+    data.width = props.Width;
+    data.height = props.Height;
+    graphics_context = std::make_unique<GraphicsContext>(vk::Extent2D{props.Width, props.Height});
+    return;
+  }
+
   init(props);
   graphics_context = std::make_unique<GraphicsContext>(window);
 }
@@ -111,10 +119,18 @@ void Window::init(const WindowProps& props) {
 
 void Window::shutdown() {
   graphics_context = nullptr;
-  glfwDestroyWindow(window);
-  glfwTerminate();
+  if (window) {
+    glfwDestroyWindow(window);
+    glfwTerminate();
+  }
 }
 
-void Window::onUpdate() { glfwPollEvents(); }
+void Window::onUpdate() {
+  if (window) {
+    glfwPollEvents();
+    // the swapchain may be recreated on the render thread, which can't query glfw
+    graphics_context->updateFramebufferSize();
+  }
+}
 
 }  // namespace TE
\ No newline at end of file
@@ -11,9 +11,11 @@ struct WindowProps {
   std::string Title;
   uint32_t Width;
   uint32_t Height;
+  bool Headless;
 
-  WindowProps(const std::string& title = "ToyEngine", uint32_t width = 1280, uint32_t height = 720)
-      : Title(title), Width(width), Height(height) {}
+  WindowProps(const std::string& title = "ToyEngine", uint32_t width = 1280, uint32_t height = 720,
+              bool headless = false)
+      : Title(title), Width(width), Height(height), Headless(headless) {}
 };
 
 class Window {
@@ -30,7 +32,9 @@ class Window {
 
   inline void setEventCallback(const EventCallbackFn& callback) { data.event_callback = callback; }
 
+  // nullptr for headless windows
   inline GLFWwindow* getNativeWindow() const { return window; }
+  inline bool isHeadless() const { return window == nullptr; }
 
   static std::unique_ptr<Window> create(const WindowProps& props = WindowProps());
 
@@ -45,7 +49,7 @@ class Window {
     EventCallbackFn event_callback;
   };
 
-  GLFWwindow* window;
+  GLFWwindow* window = nullptr;
   WindowData data;
   std::unique_ptr<GraphicsContext> graphics_context;
 };
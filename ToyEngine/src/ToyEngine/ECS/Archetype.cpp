@@ -0,0 +1,95 @@
+#include "Archetype.hpp"
+
+#include <cstring>
+#include <new>
+
+#include "tepch.hpp"
+
+namespace TE {
+namespace {
+uint32_t alignUp(uint32_t value, uint32_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+void Archetype::ChunkDeleter::operator()(std::byte* data) const {
+  ::operator delete[](data, std::align_val_t{CHUNK_ALIGNMENT});
+}
+
+Archetype::Archetype(const ComponentMask& mask) : mask{mask} {
+  columns.fill(NO_COLUMN);
+
+  uint32_t entity_size = sizeof(Entity);
+  for (ComponentId id = 0; id < MAX_COMPONENTS; id++) {
+    if (!mask.test(id)) {
+      continue;
+    }
+
+    auto& info = getComponentInfo(id);
+    if (info.alignment > CHUNK_ALIGNMENT) {
+      throw std::runtime_error("Component alignment exceeds the chunk alignment");
+    }
+    columns[id] = ids.size();
+    ids.push_back(id);
+    sizes.push_back(info.size);
+    entity_size += info.size;
+  }
+
+  // the arrays are padded for alignment, shrink until the layout fits
+  offsets.resize(ids.size());
+  for (capacity = CHUNK_SIZE / entity_size; capacity > 0; capacity--) {
+    uint32_t offset = sizeof(Entity) * capacity;
+    for (uint32_t column = 0; column < ids.size(); column++) {
+      offset = alignUp(offset, getComponentInfo(ids[column]).alignment);
+      offsets[column] = offset;
+      offset += sizes[column] * capacity;
+    }
+    if (offset <= CHUNK_SIZE) {
+      break;
+    }
+  }
+  if (capacity == 0) {
+    throw std::runtime_error("Components don't fit into an archetype chunk");
+  }
+}
+
+uint32_t Archetype::allocate(Entity entity) {
+  if (chunks.empty() || chunks.back().count == capacity) {
+    auto* data = static_cast<std::byte*>(
+        ::operator new[](CHUNK_SIZE, std::align_val_t{CHUNK_ALIGNMENT}));
+    chunks.push_back({.data = {data, ChunkDeleter{}}, .count = 0});
+  }
+
+  auto& chunk = chunks.back();
+  reinterpret_cast<Entity*>(chunk.data.get())[chunk.count++] = entity;
+  return count++;
+}
+
+Entity Archetype::remove(uint32_t row) {
+  uint32_t last = count - 1;
+  Entity moved{};
+  if (row != last) {
+    auto& dst = chunks[row / capacity];
+    auto& src = chunks[last / capacity];
+    uint32_t dst_index = row % capacity;
+    uint32_t src_index = last % capacity;
+    for (uint32_t column = 0; column < ids.size(); column++) {
+      std::memcpy(dst.data.get() + offsets[column] + sizes[column] * dst_index,
+                  src.data.get() + offsets[column] + sizes[column] * src_index, sizes[column]);
+    }
+    moved = reinterpret_cast<Entity*>(src.data.get())[src_index];
+    reinterpret_cast<Entity*>(dst.data.get())[dst_index] = moved;
+  }
+
+  if (--chunks.back().count == 0) {
+    chunks.pop_back();
+  }
+  count--;
+  return moved;
+}
+
+void* Archetype::getComponent(uint32_t row, uint32_t column) {
+  auto& chunk = chunks[row / capacity];
+  return chunk.data.get() + offsets[column] + sizes[column] * (row % capacity);
+}
+}  // namespace TE
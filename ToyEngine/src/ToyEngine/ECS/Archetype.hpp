@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <span>
+
+#include "ToyEngine/ECS/Component.hpp"
+#include "ToyEngine/ECS/Entity.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Storage of all entities with the same set of components. Entities are packed into fixed size
+// chunks holding one array per component, so iterating a component reads memory linearly. Rows
+// are indices over all chunks, removing an entity moves the last one into its row.
+class Archetype {
+ public:
+  static constexpr uint32_t CHUNK_SIZE = 16 * 1024;
+  static constexpr uint32_t CHUNK_ALIGNMENT = 64;
+  static constexpr uint32_t NO_COLUMN = UINT32_MAX;
+
+  struct ChunkDeleter {
+    void operator()(std::byte* data) const;
+  };
+
+  struct Chunk {
+    std::unique_ptr<std::byte[], ChunkDeleter> data;
+    uint32_t count = 0;
+  };
+
+  Archetype(const ComponentMask& mask);
+
+  // Appends the entity with uninitialized components and returns its row.
+  uint32_t allocate(Entity entity);
+  // Returns the entity moved into the row, invalid if the row was the last one.
+  Entity remove(uint32_t row);
+
+  void* getComponent(uint32_t row, uint32_t column);
+  inline Entity getEntity(uint32_t row) const {
+    auto& chunk = chunks[row / capacity];
+    return reinterpret_cast<const Entity*>(chunk.data.get())[row % capacity];
+  }
+
+  inline uint32_t getColumn(ComponentId id) const { return columns[id]; }
+  inline const std::vector<ComponentId>& getComponentIds() const { return ids; }
+  inline const ComponentMask& getMask() const { return mask; }
+  inline const std::vector<Chunk>& getChunks() const { return chunks; }
+  inline uint32_t getChunkCapacity() const { return capacity; }
+  inline size_t size() const { return count; }
+
+  inline std::span<const Entity> getEntities(const Chunk& chunk) const {
+    return {reinterpret_cast<const Entity*>(chunk.data.get()), chunk.count};
+  }
+  template <typename T>
+  inline std::span<T> getComponents(const Chunk& chunk, uint32_t column) const {
+    return {reinterpret_cast<T*>(chunk.data.get() + offsets[column]), chunk.count};
+  }
+
+  // archetypes with one component more or less, filled in by the World
+  std::array<Archetype*, MAX_COMPONENTS> add_edges{};
+  std::array<Archetype*, MAX_COMPONENTS> remove_edges{};
+
+ private:
+  ComponentMask mask;
+  std::vector<ComponentId> ids;     // per column
+  std::vector<uint32_t> sizes;      // per column
+  std::vector<uint32_t> offsets;    // per column, of the array in a chunk
+  std::array<uint32_t, MAX_COMPONENTS> columns;  // per component id
+  uint32_t capacity;                // entities per chunk
+  std::vector<Chunk> chunks;
+  size_t count = 0;
+};
+}  // namespace TE
@@ -0,0 +1,26 @@
+#include "Component.hpp"
+
+#include <array>
+#include <mutex>
+
+#include "tepch.hpp"
+
+namespace TE {
+namespace {
+std::mutex mutex;
+std::array<ComponentInfo, MAX_COMPONENTS> infos;
+uint32_t count = 0;
+}  // namespace
+
+ComponentId registerComponent(const ComponentInfo& info) {
+  std::lock_guard lock{mutex};
+  if (count == MAX_COMPONENTS) {
+    throw std::runtime_error("Too many component types");
+  }
+  infos[count] = info;
+  return count++;
+}
+
+// the id is returned after the info is written, so reading needs no lock
+const ComponentInfo& getComponentInfo(ComponentId id) { return infos[id]; }
+}  // namespace TE
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <bitset>
+#include <type_traits>
+
+#include "tepch.hpp"
+
+namespace TE {
+using ComponentId = uint32_t;
+
+constexpr uint32_t MAX_COMPONENTS = 64;
+using ComponentMask = std::bitset<MAX_COMPONENTS>;
+
+struct ComponentInfo {
+  uint32_t size;
+  uint32_t alignment;
+};
+
+// Components are plain data, chunks move them with memcpy and never run destructors.
+template <typename T>
+concept Component = std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>;
+
+ComponentId registerComponent(const ComponentInfo& info);
+const ComponentInfo& getComponentInfo(ComponentId id);
+
+// Ids are assigned on first use and are the same for every World.
+template <Component T>
+inline ComponentId getComponentId() {
+  static const ComponentId id = registerComponent({sizeof(T), alignof(T)});
+  return id;
+}
+
+template <Component... Ts>
+inline ComponentMask getComponentMask() {
+  ComponentMask mask;
+  (mask.set(getComponentId<Ts>()), ...);
+  return mask;
+}
+}  // namespace TE
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "tepch.hpp"
+
+namespace TE {
+// Handle to an entity of a World. The generation detects handles to destroyed entities whose
+// index has been reused.
+struct Entity {
+  static constexpr uint32_t INVALID = UINT32_MAX;
+
+  uint32_t index = INVALID;
+  uint32_t generation = 0;
+
+  inline bool isValid() const { return index != INVALID; }
+  bool operator==(const Entity&) const = default;
+};
+}  // namespace TE
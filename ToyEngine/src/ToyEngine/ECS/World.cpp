@@ -0,0 +1,163 @@
+#include "World.hpp"
+
+#include "tepch.hpp"
+
+namespace TE {
+World::World() { empty = &getArchetype({}); }
+
+Entity World::allocateEntity() {
+  alive++;
+  if (!free_indices.empty()) {
+    uint32_t index = free_indices.back();
+    free_indices.pop_back();
+    return {index, records[index].generation};
+  }
+
+  records.emplace_back();
+  return {static_cast<uint32_t>(records.size() - 1), 0};
+}
+
+void World::place(Entity entity, Archetype& archetype) {
+  auto& record = records[entity.index];
+  record.archetype = &archetype;
+  record.row = archetype.allocate(entity);
+}
+
+bool World::isAlive(Entity entity) const {
+  return entity.index < records.size() && records[entity.index].generation == entity.generation;
+}
+
+void World::destroy(Entity entity) {
+  if (iterating > 0) {
+    deferred.push_back([this, entity] {
+      if (isAlive(entity)) {
+        destroyEntity(entity);
+      }
+    });
+    return;
+  }
+  destroyEntity(entity);
+}
+
+void World::destroyEntity(Entity entity) {
+  assert(isAlive(entity));
+  auto& record = records[entity.index];
+  if (record.archetype) {
+    Entity moved = record.archetype->remove(record.row);
+    if (moved.isValid()) {
+      records[moved.index].row = record.row;
+    }
+  }
+
+  record = {.archetype = nullptr, .row = 0, .generation = record.generation + 1};
+  free_indices.push_back(entity.index);
+  alive--;
+}
+
+void* World::addComponent(Entity entity, ComponentId id) {
+  assert(isAlive(entity));
+  auto& record = records[entity.index];
+  Archetype& source = record.archetype ? *record.archetype : *empty;
+  if (record.archetype && source.getColumn(id) != Archetype::NO_COLUMN) {
+    return source.getComponent(record.row, source.getColumn(id));
+  }
+
+  Archetype* target = source.add_edges[id];
+  if (!target) {
+    ComponentMask mask = source.getMask();
+    target = &getArchetype(mask.set(id));
+    source.add_edges[id] = target;
+  }
+
+  // move the shared components, the new one is written by the caller
+  uint32_t row = target->allocate(entity);
+  if (record.archetype) {
+    for (ComponentId shared : source.getComponentIds()) {
+      std::memcpy(target->getComponent(row, target->getColumn(shared)),
+                  source.getComponent(record.row, source.getColumn(shared)),
+                  getComponentInfo(shared).size);
+    }
+    Entity moved = source.remove(record.row);
+    if (moved.isValid()) {
+      records[moved.index].row = record.row;
+    }
+  }
+
+  record.archetype = target;
+  record.row = row;
+  return target->getComponent(row, target->getColumn(id));
+}
+
+void World::removeComponent(Entity entity, ComponentId id) {
+  assert(isAlive(entity));
+  auto& record = records[entity.index];
+  Archetype* source = record.archetype;
+  if (!source || source->getColumn(id) == Archetype::NO_COLUMN) {
+    return;
+  }
+
+  Archetype* target = source->remove_edges[id];
+  if (!target) {
+    ComponentMask mask = source->getMask();
+    target = &getArchetype(mask.reset(id));
+    source->remove_edges[id] = target;
+  }
+
+  uint32_t row = target->allocate(entity);
+  for (ComponentId kept : target->getComponentIds()) {
+    std::memcpy(target->getComponent(row, target->getColumn(kept)),
+                source->getComponent(record.row, source->getColumn(kept)),
+                getComponentInfo(kept).size);
+  }
+  Entity moved = source->remove(record.row);
+  if (moved.isValid()) {
+    records[moved.index].row = record.row;
+  }
+
+  record.archetype = target;
+  record.row = row;
+}
+
+void* World::getComponent(Entity entity, ComponentId id) {
+  assert(isAlive(entity));
+  auto& record = records[entity.index];
+  assert(record.archetype && record.archetype->getColumn(id) != Archetype::NO_COLUMN);
+  return record.archetype->getComponent(record.row, record.archetype->getColumn(id));
+}
+
+Archetype& World::getArchetype(const ComponentMask& mask) {
+  auto& archetype = archetypes[mask];
+  if (archetype) {
+    return *archetype;
+  }
+
+  archetype = std::make_unique<Archetype>(mask);
+  for (auto& [query, matching] : queries) {
+    if ((mask & query) == query) {
+      matching.push_back(archetype.get());
+    }
+  }
+  return *archetype;
+}
+
+const std::vector<Archetype*>& World::getMatching(const ComponentMask& mask) {
+  auto [it, inserted] = queries.try_emplace(mask);
+  if (inserted) {
+    for (auto& [archetype_mask, archetype] : archetypes) {
+      if ((archetype_mask & mask) == mask) {
+        it->second.push_back(archetype.get());
+      }
+    }
+  }
+  return it->second;
+}
+
+void World::flush() {
+  // applying a change may not defer further ones, nothing is iterating
+  auto changes = std::move(deferred);
+  deferred.clear();
+  for (auto& change : changes) {
+    change();
+  }
+}
+}  // namespace TE
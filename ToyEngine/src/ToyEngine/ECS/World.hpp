@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstring>
+#include <span>
+#include <unordered_map>
+#include <utility>
+
+#include "ToyEngine/ECS/Archetype.hpp"
+#include "ToyEngine/ECS/Component.hpp"
+#include "ToyEngine/ECS/Entity.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Archetype based entity component system. Entities with the same set of components share an
+// Archetype, queries visit the chunks of all matching archetypes. Adding or removing components
+// moves the entity to another archetype, which invalidates references to its components.
+// Structural changes made while iterating are deferred until the outermost iteration ends.
+class World {
+ public:
+  World();
+
+  template <Component... Ts>
+  Entity create(const Ts&... components);
+  void destroy(Entity entity);
+  bool isAlive(Entity entity) const;
+
+  // Replaces the component if the entity already has one.
+  template <Component T>
+  void add(Entity entity, const T& component);
+  template <Component T>
+  void remove(Entity entity);
+  template <Component T>
+  bool has(Entity entity) const;
+  template <Component T>
+  T& get(Entity entity);
+
+  // Calls function(Entity, Ts&...) for every entity having all components, const components
+  // are passed as const references.
+  template <typename... Ts, typename F>
+  void each(F&& function);
+  // Calls function(std::span<const Entity>, std::span<Ts>...) once per chunk.
+  template <typename... Ts, typename F>
+  void eachChunk(F&& function);
+  // number of entities having all components
+  template <Component... Ts>
+  size_t count();
+
+  inline size_t size() const { return alive; }
+
+ private:
+  struct Record {
+    Archetype* archetype = nullptr;  // null until a deferred create is applied
+    uint32_t row = 0;
+    uint32_t generation = 0;
+  };
+
+  Entity allocateEntity();
+  void place(Entity entity, Archetype& archetype);
+  void destroyEntity(Entity entity);
+  void* addComponent(Entity entity, ComponentId id);
+  void removeComponent(Entity entity, ComponentId id);
+  void* getComponent(Entity entity, ComponentId id);
+  Archetype& getArchetype(const ComponentMask& mask);
+  const std::vector<Archetype*>& getMatching(const ComponentMask& mask);
+  void flush();
+
+  std::vector<Record> records;
+  std::vector<uint32_t> free_indices;
+  size_t alive = 0;
+
+  std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> archetypes;
+  std::unordered_map<ComponentMask, std::vector<Archetype*>> queries;  // matching archetypes
+  Archetype* empty;
+
+  uint32_t iterating = 0;
+  std::vector<std::function<void()>> deferred;
+};
+
+template <Component... Ts>
+Entity World::create(const Ts&... components) {
+  Entity entity = allocateEntity();
+  if (iterating > 0) {
+    deferred.push_back([this, entity, components...] {
+      if (isAlive(entity)) {
+        place(entity, getArchetype(getComponentMask<Ts...>()));
+        (std::memcpy(getComponent(entity, getComponentId<Ts>()), &components, sizeof(Ts)), ...);
+      }
+    });
+    return entity;
+  }
+
+  place(entity, getArchetype(getComponentMask<Ts...>()));
+  (std::memcpy(getComponent(entity, getComponentId<Ts>()), &components, sizeof(Ts)), ...);
+  return entity;
+}
+
+template <Component T>
+void World::add(Entity entity, const T& component) {
+  if (iterating > 0) {
+    deferred.push_back([this, entity, component] {
+      if (isAlive(entity)) {
+        std::memcpy(addComponent(entity, getComponentId<T>()), &component, sizeof(T));
+      }
+    });
+    return;
+  }
+  std::memcpy(addComponent(entity, getComponentId<T>()), &component, sizeof(T));
+}
+
+template <Component T>
+void World::remove(Entity entity) {
+  if (iterating > 0) {
+    deferred.push_back([this, entity] {
+      if (isAlive(entity)) {
+        removeComponent(entity, getComponentId<T>());
+      }
+    });
+    return;
+  }
+  removeComponent(entity, getComponentId<T>());
+}
+
+template <Component T>
+bool World::has(Entity entity) const {
+  assert(isAlive(entity));
+  auto* archetype = records[entity.index].archetype;
+  return archetype && archetype->getMask().test(getComponentId<T>());
+}
+
+template <Component T>
+T& World::get(Entity entity) {
+  return *static_cast<T*>(getComponent(entity, getComponentId<T>()));
+}
+
+template <typename... Ts, typename F>
+void World::each(F&& function) {
+  eachChunk<Ts...>([&](std::span<const Entity> entities, std::span<Ts>... components) {
+    for (size_t i = 0; i < entities.size(); i++) {
+      function(entities[i], components[i]...);
+    }
+  });
+}
+
+template <typename... Ts, typename F>
+void World::eachChunk(F&& function) {
+  auto& matching = getMatching(getComponentMask<std::remove_const_t<Ts>...>());
+
+  iterating++;
+  for (Archetype* archetype : matching) {
+    std::array<uint32_t, sizeof...(Ts)> columns{
+        archetype->getColumn(getComponentId<std::remove_const_t<Ts>>())...};
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      for (auto& chunk : archetype->getChunks()) {
+        function(archetype->getEntities(chunk), archetype->getComponents<Ts>(chunk, columns[I])...);
+      }
+    }(std::index_sequence_for<Ts...>{});
+  }
+  if (--iterating == 0) {
+    flush();
+  }
+}
+
+template <Component... Ts>
+size_t World::count() {
+  size_t total = 0;
+  for (Archetype* archetype : getMatching(getComponentMask<Ts...>())) {
+    total += archetype->size();
+  }
+  return total;
+}
+}  // namespace TE
@@ -16,6 +16,22 @@
 #include "tepch.hpp"
 
 namespace TE {
+namespace {
+std::shared_ptr<ImDrawData> copyDrawData(const ImDrawData& draw_data) {
+  auto destroy = [](ImDrawData* data) {
+    for (ImDrawList* list : data->CmdLists) {
+      IM_DELETE(list);
+    }
+    delete data;
+  };
+
+  std::shared_ptr<ImDrawData> copy{new ImDrawData(draw_data), destroy};
+  for (ImDrawList*& list : copy->CmdLists) {
+    list = list->CloneOutput();
+  }
+  return copy;
+}
+}  // namespace
 
 ImGuiLayer::ImGuiLayer() : Layer("ImGuiLayer") {}
 
@@ -61,12 +77,15 @@ void ImGuiLayer::onAttach() {
   init_info.Device = ctx.getDevice();
   init_info.QueueFamily = ctx.getGraphicsQueueIndex();
   init_info.Queue = ctx.getQueue();
+  init_info.PipelineCache = ctx.getPipelineCache();
   init_info.DescriptorPool = descriptor_pool;
   init_info.RenderPass = render_pass;
   init_info.MinImageCount = ctx.getSwapChain().getImageCount();
   init_info.ImageCount = ctx.getSwapChain().getImageCount();
   init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
   ImGui_ImplVulkan_Init(&init_info);
+  // NewFrame() would otherwise upload the fonts on the queue the render thread submits to
+  ImGui_ImplVulkan_CreateFontsTexture();
 }
 
 void ImGuiLayer::onDetach() {
@@ -87,23 +106,32 @@ void ImGuiLayer::onUpdate([[maybe_unused]] Timestep dt) {
 
   ImGui::ShowDemoWindow();
 
+  ImGui::Begin("GPU Profiler");
+  for (const auto& timing : GraphicsContext::get().getGpuTimings()) {
+    ImGui::Text("%*s%s: %.3f ms", static_cast<int>(timing.depth * 2), "", timing.name.c_str(),
+                timing.milliseconds);
+  }
+  ImGui::End();
+
   ImGui::Render();
-  ImDrawData* draw_data = ImGui::GetDrawData();
-
-  GraphicsContext::get().record([=, this](auto cmd) {
-    auto& swapchain = GraphicsContext::get().getSwapChain();
-    vk::ClearValue clear_value{{{{0.01f, 0.01f, 0.033f, 1.0f}}}};
-
-    vk::RenderPassBeginInfo render_pass_info{
-        .renderPass = render_pass,
-        .framebuffer = swapchain.getFramebuffer(),
-        .renderArea = {{0, 0}, swapchain.getExtent()},
-        .clearValueCount = 1,
-        .pClearValues = &clear_value,
-    };
-    cmd.beginRenderPass(render_pass_info, vk::SubpassContents::eInline);
-    ImGui_ImplVulkan_RenderDrawData(draw_data, cmd);
-    cmd.endRenderPass();
+
+  // the next ImGui::Render() reuses the draw lists, the render command gets a copy
+  Application::get().submit([this, draw_data = copyDrawData(*ImGui::GetDrawData())] {
+    GraphicsContext::get().record("ImGui", [&](vk::CommandBuffer cmd) {
+      auto& swapchain = GraphicsContext::get().getSwapChain();
+      vk::ClearValue clear_value{{{{0.01f, 0.01f, 0.033f, 1.0f}}}};
+
+      vk::RenderPassBeginInfo render_pass_info{
+          .renderPass = render_pass,
+          .framebuffer = swapchain.getFramebuffer(),
+          .renderArea = {{0, 0}, swapchain.getExtent()},
+          .clearValueCount = 1,
+          .pClearValues = &clear_value,
+      };
+      cmd.beginRenderPass(render_pass_info, vk::SubpassContents::eInline);
+      ImGui_ImplVulkan_RenderDrawData(draw_data.get(), cmd);
+      cmd.endRenderPass();
+    });
   });
 }
 
@@ -124,7 +152,7 @@ void ImGuiLayer::createRenderPass(const GraphicsContext& ctx) {
       .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
       .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
       .initialLayout = vk::ImageLayout::eUndefined,
-      .finalLayout = vk::ImageLayout::ePresentSrcKHR,
+      .finalLayout = ctx.getSwapChain().getFinalLayout(),
   };
 
   vk::AttachmentReference color_attachment_ref{
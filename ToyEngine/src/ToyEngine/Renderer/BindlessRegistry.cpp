@@ -0,0 +1,214 @@
+#include "BindlessRegistry.hpp"
+
+#include <array>
+#include <vulkan/vulkan.hpp>
+
+namespace TE {
+namespace {
+constexpr std::array<vk::DescriptorType, 3> DESCRIPTOR_TYPES = {
+    vk::DescriptorType::eUniformBuffer,
+    vk::DescriptorType::eStorageBuffer,
+    vk::DescriptorType::eCombinedImageSampler,
+};
+}  // namespace
+
+BindlessRegistry::BindlessRegistry(const Device& device, uint32_t frames_in_flight)
+    : device{device}, frames_in_flight{frames_in_flight} {
+  computeCapacities();
+
+  std::array<vk::DescriptorSetLayoutBinding, DESCRIPTOR_TYPES.size()> layout_bindings;
+  std::array<vk::DescriptorBindingFlags, DESCRIPTOR_TYPES.size()> layout_flags;
+  std::array<vk::DescriptorPoolSize, DESCRIPTOR_TYPES.size()> pool_sizes;
+  for (uint32_t i = 0; i < DESCRIPTOR_TYPES.size(); i++) {
+    layout_bindings[i] = {
+        .binding = i,
+        .descriptorType = DESCRIPTOR_TYPES[i],
+        .descriptorCount = slots[i].capacity,
+        .stageFlags = vk::ShaderStageFlagBits::eAll,
+    };
+    layout_flags[i] = vk::DescriptorBindingFlagBits::ePartiallyBound |
+                      vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+                      vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+    pool_sizes[i] = {
+        .type = DESCRIPTOR_TYPES[i],
+        .descriptorCount = slots[i].capacity,
+    };
+  }
+
+  vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags{
+      .bindingCount = layout_flags.size(),
+      .pBindingFlags = layout_flags.data(),
+  };
+  vk::DescriptorSetLayoutCreateInfo layout_info{
+      .pNext = &binding_flags,
+      .flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+      .bindingCount = layout_bindings.size(),
+      .pBindings = layout_bindings.data(),
+  };
+  descriptor_set_layout = device.getDevice().createDescriptorSetLayout(layout_info);
+
+  vk::DescriptorPoolCreateInfo pool_info{
+      .flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+      .maxSets = 1,
+      .poolSizeCount = pool_sizes.size(),
+      .pPoolSizes = pool_sizes.data(),
+  };
+  descriptor_pool = device.getDevice().createDescriptorPool(pool_info);
+
+  vk::DescriptorSetAllocateInfo alloc_info{
+      .descriptorPool = descriptor_pool,
+      .descriptorSetCount = 1,
+      .pSetLayouts = &descriptor_set_layout,
+  };
+  descriptor_set = device.getDevice().allocateDescriptorSets(alloc_info)[0];
+}
+
+BindlessRegistry::~BindlessRegistry() {
+  device.getDevice().destroyDescriptorPool(descriptor_pool);
+  device.getDevice().destroyDescriptorSetLayout(descriptor_set_layout);
+}
+
+vk::DescriptorType BindlessRegistry::getDescriptorType(BindlessType type) {
+  return DESCRIPTOR_TYPES[static_cast<uint32_t>(type)];
+}
+
+UniformBufferHandle BindlessRegistry::registerUniformBuffer(const vk::DescriptorBufferInfo& info) {
+  UniformBufferHandle handle{allocate(BindlessType::UNIFORM_BUFFER)};
+  update(handle, info);
+  return handle;
+}
+
+StorageBufferHandle BindlessRegistry::registerStorageBuffer(const vk::DescriptorBufferInfo& info) {
+  StorageBufferHandle handle{allocate(BindlessType::STORAGE_BUFFER)};
+  update(handle, info);
+  return handle;
+}
+
+TextureHandle BindlessRegistry::registerTexture(const vk::DescriptorImageInfo& info) {
+  TextureHandle handle{allocate(BindlessType::TEXTURE)};
+  update(handle, info);
+  return handle;
+}
+
+void BindlessRegistry::update(UniformBufferHandle handle, const vk::DescriptorBufferInfo& info) {
+  std::lock_guard lock{mutex};
+  pending_writes.push_back(
+      {.type = BindlessType::UNIFORM_BUFFER, .index = handle.index, .buffer_info = info});
+}
+
+void BindlessRegistry::update(StorageBufferHandle handle, const vk::DescriptorBufferInfo& info) {
+  std::lock_guard lock{mutex};
+  pending_writes.push_back(
+      {.type = BindlessType::STORAGE_BUFFER, .index = handle.index, .buffer_info = info});
+}
+
+void BindlessRegistry::update(TextureHandle handle, const vk::DescriptorImageInfo& info) {
+  std::lock_guard lock{mutex};
+  pending_writes.push_back(
+      {.type = BindlessType::TEXTURE, .index = handle.index, .image_info = info});
+}
+
+void BindlessRegistry::flush() {
+  std::lock_guard lock{mutex};
+  frame++;
+
+  // slots released frames_in_flight frames ago are no longer referenced by the GPU
+  std::erase_if(pending_releases, [this](const PendingRelease& release) {
+    if (release.frame + frames_in_flight > frame) {
+      return false;
+    }
+    slots[static_cast<uint32_t>(release.type)].free.push_back(release.index);
+    return true;
+  });
+
+  writePending();
+}
+
+void BindlessRegistry::writeDescriptors() {
+  std::lock_guard lock{mutex};
+  writePending();
+}
+
+void BindlessRegistry::writePending() {
+  if (pending_writes.empty()) {
+    return;
+  }
+
+  std::vector<vk::WriteDescriptorSet> writes;
+  writes.reserve(pending_writes.size());
+  for (const auto& pending : pending_writes) {
+    auto binding = static_cast<uint32_t>(pending.type);
+    writes.push_back({
+        .dstSet = descriptor_set,
+        .dstBinding = binding,
+        .dstArrayElement = pending.index,
+        .descriptorCount = 1,
+        .descriptorType = DESCRIPTOR_TYPES[binding],
+        .pImageInfo = &pending.image_info,
+        .pBufferInfo = &pending.buffer_info,
+    });
+  }
+  device.getDevice().updateDescriptorSets(writes, nullptr);
+  pending_writes.clear();
+}
+
+void BindlessRegistry::computeCapacities() {
+  const auto& limits = device.getDescriptorIndexingProperties();
+
+  // all bindings are visible to every stage, so the per-stage limits apply as well
+  auto& uniform_buffers = slots[static_cast<uint32_t>(BindlessType::UNIFORM_BUFFER)];
+  uniform_buffers.capacity = std::min({
+      MAX_UNIFORM_BUFFERS,
+      limits.maxDescriptorSetUpdateAfterBindUniformBuffers,
+      limits.maxPerStageDescriptorUpdateAfterBindUniformBuffers,
+  });
+
+  auto& storage_buffers = slots[static_cast<uint32_t>(BindlessType::STORAGE_BUFFER)];
+  storage_buffers.capacity = std::min({
+      MAX_STORAGE_BUFFERS,
+      limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+      limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+  });
+
+  // combined image samplers count as both a sampled image and a sampler
+  auto& textures = slots[static_cast<uint32_t>(BindlessType::TEXTURE)];
+  textures.capacity = std::min({
+      MAX_TEXTURES,
+      limits.maxDescriptorSetUpdateAfterBindSampledImages,
+      limits.maxDescriptorSetUpdateAfterBindSamplers,
+      limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+      limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+  });
+
+  // the buffers keep their capacities, the textures get what the per-stage limit leaves
+  uint32_t buffers = uniform_buffers.capacity + storage_buffers.capacity;
+  uint32_t resources = limits.maxPerStageUpdateAfterBindResources;
+  textures.capacity = std::min(textures.capacity, buffers >= resources ? 0 : resources - buffers);
+  if (textures.capacity == 0) {
+    throw std::runtime_error("No bindless texture slots left by the per-stage resource limit");
+  }
+}
+
+uint32_t BindlessRegistry::allocate(BindlessType type) {
+  std::lock_guard lock{mutex};
+  auto& slot = slots[static_cast<uint32_t>(type)];
+
+  if (!slot.free.empty()) {
+    uint32_t index = slot.free.back();
+    slot.free.pop_back();
+    return index;
+  }
+
+  if (slot.next == slot.capacity) {
+    throw std::runtime_error("Out of bindless descriptor slots");
+  }
+  return slot.next++;
+}
+
+void BindlessRegistry::release(BindlessType type, uint32_t index) {
+  if (index != UINT32_MAX) {
+    std::lock_guard lock{mutex};
+    pending_releases.push_back({.type = type, .index = index, .frame = frame});
+  }
+}
+}  // namespace TE
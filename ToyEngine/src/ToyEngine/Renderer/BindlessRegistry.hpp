@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/Device.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// The value is the binding of the resource type in the global descriptor set.
+enum class BindlessType : uint32_t {
+  UNIFORM_BUFFER = 0,
+  STORAGE_BUFFER = 1,
+  TEXTURE = 2,
+};
+
+// Typed index into one of the global descriptor arrays, pass index to shaders to access the
+// resource.
+template <BindlessType Type>
+struct BindlessHandle {
+  static constexpr uint32_t INVALID = UINT32_MAX;
+  uint32_t index = INVALID;
+
+  inline bool isValid() const { return index != INVALID; }
+};
+
+using UniformBufferHandle = BindlessHandle<BindlessType::UNIFORM_BUFFER>;
+using StorageBufferHandle = BindlessHandle<BindlessType::STORAGE_BUFFER>;
+using TextureHandle = BindlessHandle<BindlessType::TEXTURE>;
+
+// Owns the global update-after-bind descriptor set and hands out its array elements. Descriptor
+// writes are batched until the next flush() and released slots are only reused once no frame in
+// flight can reference them anymore. Resources may be registered and released from any thread.
+class BindlessRegistry {
+ public:
+  BindlessRegistry(const Device& device, uint32_t frames_in_flight);
+  ~BindlessRegistry();
+
+  UniformBufferHandle registerUniformBuffer(const vk::DescriptorBufferInfo& info);
+  StorageBufferHandle registerStorageBuffer(const vk::DescriptorBufferInfo& info);
+  TextureHandle registerTexture(const vk::DescriptorImageInfo& info);
+
+  void update(UniformBufferHandle handle, const vk::DescriptorBufferInfo& info);
+  void update(StorageBufferHandle handle, const vk::DescriptorBufferInfo& info);
+  void update(TextureHandle handle, const vk::DescriptorImageInfo& info);
+
+  template <BindlessType Type>
+  inline void release(BindlessHandle<Type> handle) {
+    release(Type, handle.index);
+  }
+
+  // Writes all pending descriptor updates, to be called once per frame before recording.
+  void flush();
+  // Writes the pending updates without advancing the frame. Update-after-bind makes writes made
+  // while recording visible to the frame, as long as they happen before submission.
+  void writeDescriptors();
+
+  inline vk::DescriptorSet getDescriptorSet() const { return descriptor_set; }
+  inline vk::DescriptorSetLayout getDescriptorSetLayout() const { return descriptor_set_layout; }
+  inline uint32_t getCapacity(BindlessType type) const {
+    return slots[static_cast<uint32_t>(type)].capacity;
+  }
+
+  static vk::DescriptorType getDescriptorType(BindlessType type);
+
+ private:
+  struct Slots {
+    uint32_t capacity = 0;
+    uint32_t next = 0;
+    std::vector<uint32_t> free;
+  };
+
+  struct PendingRelease {
+    BindlessType type;
+    uint32_t index;
+    uint64_t frame;
+  };
+
+  struct PendingWrite {
+    BindlessType type;
+    uint32_t index;
+    vk::DescriptorBufferInfo buffer_info;
+    vk::DescriptorImageInfo image_info;
+  };
+
+  void computeCapacities();
+  // expects the mutex to be held
+  void writePending();
+  uint32_t allocate(BindlessType type);
+  void release(BindlessType type, uint32_t index);
+
+  const Device& device;
+  uint32_t frames_in_flight;
+  uint64_t frame = 0;
+
+  vk::DescriptorSetLayout descriptor_set_layout;
+  vk::DescriptorPool descriptor_pool;
+  vk::DescriptorSet descriptor_set;
+
+  std::array<Slots, 3> slots;
+  std::vector<PendingRelease> pending_releases;
+  std::vector<PendingWrite> pending_writes;
+  std::mutex mutex;
+
+  // upper bounds, the actual sizes are limited further by the device
+  static constexpr uint32_t MAX_UNIFORM_BUFFERS = 4096;
+  static constexpr uint32_t MAX_STORAGE_BUFFERS = 4096;
+  static constexpr uint32_t MAX_TEXTURES = 65536;
+};
+}  // namespace TE
@@ -0,0 +1,461 @@
+#include "BlockCompression.hpp"
+
+#include <array>
+#include <cstring>
+
+#include "stb_dxt.h"
+#include "tepch.hpp"
+
+namespace TE {
+namespace {
+// 16 RGBA8 texels of a 4x4 block in row order
+using BlockTexels = std::array<uint8_t, 16 * 4>;
+
+// subset of every texel for the BC7 partitions with two subsets, bit i is texel i
+constexpr uint16_t BC7_PARTITIONS_2[64] = {
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80,
+    0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000, 0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310,
+    0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C, 0xAAAA,
+    0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC,
+    0x6996, 0xC33C, 0x9966, 0x0660, 0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6,
+    0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+// subset of every texel for the BC7 partitions with three subsets
+constexpr uint8_t BC7_PARTITIONS_3[64][16] = {
+    {0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2},
+    {0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+    {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2},
+    {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+    {0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1},
+    {0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2},
+    {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+    {0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2},
+    {0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+    {0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+    {0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+    {0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2},
+    {0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+    {0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2},
+    {0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+    {0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2},
+    {0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2},
+    {0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+    {0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0},
+    {0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+    {0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0},
+    {0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+    {0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+    {0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1},
+    {0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+    {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2},
+    {0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0},
+    {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+    {0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0},
+    {0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1},
+    {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1},
+    {0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+    {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1},
+    {0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1},
+    {0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+    {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2},
+    {0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+    {0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2},
+    {0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2},
+    {0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+    {0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+    {0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1},
+    {0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0},
+};
+
+// texels whose index is stored with one bit less, the first texel is the anchor of subset 0
+constexpr uint8_t BC7_ANCHORS_2[64] = {
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 2,  8,  2,  2,  8,
+    8,  15, 2,  8,  2,  2,  8,  8,  2,  2,  15, 15, 6,  8,  2,  8,  15, 15, 2,  8,  2,  2,
+    2,  15, 15, 6,  6,  2,  6,  8,  15, 15, 2,  2,  15, 15, 15, 15, 15, 2,  2,  15,
+};
+constexpr uint8_t BC7_ANCHORS_3_SECOND[64] = {
+    3,  3,  15, 15, 8,  3,  15, 15, 8,  8,  6,  6,  6,  5,  3,  3,  3,  3,  8,  15, 3,  3,
+    6,  10, 5,  8,  8,  6,  8,  5,  15, 15, 8,  15, 3,  5,  6,  10, 8,  15, 15, 3,  15, 5,
+    15, 15, 15, 15, 3,  15, 5,  5,  5,  8,  5,  10, 5,  10, 8,  13, 15, 12, 3,  3,
+};
+constexpr uint8_t BC7_ANCHORS_3_THIRD[64] = {
+    15, 8,  8,  3,  15, 15, 3,  8,  15, 15, 15, 15, 15, 15, 15, 8,  15, 8,  15, 3,  15, 8,
+    15, 8,  3,  15, 6,  10, 15, 15, 10, 8,  15, 3,  15, 10, 10, 8,  9,  10, 6,  15, 8,  15,
+    3,  6,  6,  8,  15, 3,  15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3,  15, 15, 8,
+};
+
+constexpr uint8_t BC7_WEIGHTS_2[4] = {0, 21, 43, 64};
+constexpr uint8_t BC7_WEIGHTS_3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+constexpr uint8_t BC7_WEIGHTS_4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct Bc7Mode {
+  uint32_t subsets;
+  uint32_t partition_bits;
+  uint32_t rotation_bits;
+  uint32_t index_selection_bits;
+  uint32_t color_bits;
+  uint32_t alpha_bits;
+  uint32_t endpoint_p_bits;  // one per endpoint
+  uint32_t shared_p_bits;    // one per subset
+  uint32_t index_bits;
+  uint32_t secondary_index_bits;
+};
+
+constexpr Bc7Mode BC7_MODES[8] = {
+    {3, 4, 0, 0, 4, 0, 1, 0, 3, 0}, {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+    {3, 6, 0, 0, 5, 0, 0, 0, 2, 0}, {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+    {1, 0, 2, 1, 5, 6, 0, 0, 2, 3}, {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+    {1, 0, 0, 0, 7, 7, 1, 0, 4, 0}, {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+// reads the bits of a block starting with the least significant bit of the first byte
+class BitReader {
+ public:
+  BitReader(const uint8_t* data) : data{data} {}
+
+  uint32_t read(uint32_t count) {
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < count; i++, position++) {
+      value |= ((data[position / 8] >> (position % 8)) & 1) << i;
+    }
+    return value;
+  }
+
+ private:
+  const uint8_t* data;
+  uint32_t position = 0;
+};
+
+uint16_t readU16(const uint8_t* data) { return data[0] | data[1] << 8; }
+
+// replicates the high bits into the low ones
+uint8_t expandBits(uint32_t value, uint32_t bits) {
+  value <<= 8 - bits;
+  return value | (value >> bits);
+}
+
+// BC3 color blocks always use four colors, BC1 ones only if the first color is the greater
+void decodeBc1(const uint8_t* block, BlockTexels& texels, bool force_four_colors) {
+  uint16_t c0 = readU16(block);
+  uint16_t c1 = readU16(block + 2);
+
+  std::array<std::array<uint8_t, 4>, 4> colors;
+  for (uint32_t i = 0; i < 2; i++) {
+    uint16_t c = i == 0 ? c0 : c1;
+    colors[i] = {expandBits(c >> 11, 5), expandBits((c >> 5) & 0x3F, 6), expandBits(c & 0x1F, 5),
+                 255};
+  }
+  for (uint32_t channel = 0; channel < 3; channel++) {
+    uint32_t a = colors[0][channel];
+    uint32_t b = colors[1][channel];
+    if (force_four_colors || c0 > c1) {
+      colors[2][channel] = (2 * a + b) / 3;
+      colors[3][channel] = (a + 2 * b) / 3;
+    } else {
+      colors[2][channel] = (a + b) / 2;
+      colors[3][channel] = 0;
+    }
+  }
+  colors[2][3] = 255;
+  // transparent black in the three color mode
+  colors[3][3] = force_four_colors || c0 > c1 ? 255 : 0;
+
+  for (uint32_t i = 0; i < 16; i++) {
+    uint32_t index = (block[4 + i / 4] >> (2 * (i % 4))) & 3;
+    std::memcpy(&texels[i * 4], colors[index].data(), 4);
+  }
+}
+
+// single channel block shared by BC3 alpha and BC5, written to every fourth byte
+void decodeBc4(const uint8_t* block, uint8_t* channel) {
+  uint32_t a = block[0];
+  uint32_t b = block[1];
+
+  uint8_t values[8] = {static_cast<uint8_t>(a), static_cast<uint8_t>(b)};
+  if (a > b) {
+    for (uint32_t i = 1; i < 7; i++) {
+      values[i + 1] = ((7 - i) * a + i * b) / 7;
+    }
+  } else {
+    for (uint32_t i = 1; i < 5; i++) {
+      values[i + 1] = ((5 - i) * a + i * b) / 5;
+    }
+    values[6] = 0;
+    values[7] = 255;
+  }
+
+  uint64_t indices = 0;
+  for (uint32_t i = 0; i < 6; i++) {
+    indices |= uint64_t{block[2 + i]} << (8 * i);
+  }
+  for (uint32_t i = 0; i < 16; i++) {
+    channel[i * 4] = values[(indices >> (3 * i)) & 7];
+  }
+}
+
+void decodeBc7(const uint8_t* block, BlockTexels& texels) {
+  uint32_t mode_index = 0;
+  while (mode_index < 8 && !(block[0] & (1 << mode_index))) {
+    mode_index++;
+  }
+  if (mode_index == 8) {
+    texels.fill(0);  // reserved mode
+    return;
+  }
+  const Bc7Mode& mode = BC7_MODES[mode_index];
+
+  BitReader bits{block};
+  bits.read(mode_index + 1);
+  uint32_t partition = bits.read(mode.partition_bits);
+  uint32_t rotation = bits.read(mode.rotation_bits);
+  uint32_t index_selection = bits.read(mode.index_selection_bits);
+
+  // endpoints of the subsets, each an RGBA color
+  uint32_t endpoint_count = mode.subsets * 2;
+  std::array<std::array<uint32_t, 4>, 6> endpoints{};
+  for (uint32_t channel = 0; channel < 3; channel++) {
+    for (uint32_t i = 0; i < endpoint_count; i++) {
+      endpoints[i][channel] = bits.read(mode.color_bits);
+    }
+  }
+  for (uint32_t i = 0; i < endpoint_count; i++) {
+    endpoints[i][3] = mode.alpha_bits ? bits.read(mode.alpha_bits) : 255;
+  }
+
+  uint32_t color_bits = mode.color_bits;
+  uint32_t alpha_bits = mode.alpha_bits;
+  if (mode.endpoint_p_bits || mode.shared_p_bits) {
+    std::array<uint32_t, 6> p_bits;
+    for (uint32_t i = 0; i < endpoint_count; i++) {
+      p_bits[i] = mode.endpoint_p_bits ? bits.read(1) : (i % 2 ? p_bits[i - 1] : bits.read(1));
+    }
+    for (uint32_t i = 0; i < endpoint_count; i++) {
+      for (uint32_t channel = 0; channel < (alpha_bits ? 4 : 3); channel++) {
+        endpoints[i][channel] = endpoints[i][channel] << 1 | p_bits[i];
+      }
+    }
+    color_bits++;
+    alpha_bits += alpha_bits ? 1 : 0;
+  }
+  for (uint32_t i = 0; i < endpoint_count; i++) {
+    for (uint32_t channel = 0; channel < 3; channel++) {
+      endpoints[i][channel] = expandBits(endpoints[i][channel], color_bits);
+    }
+    if (alpha_bits) {
+      endpoints[i][3] = expandBits(endpoints[i][3], alpha_bits);
+    }
+  }
+
+  auto getSubset = [&](uint32_t texel) -> uint32_t {
+    if (mode.subsets == 2) {
+      return (BC7_PARTITIONS_2[partition] >> texel) & 1;
+    }
+    return mode.subsets == 3 ? BC7_PARTITIONS_3[partition][texel] : 0;
+  };
+  auto isAnchor = [&](uint32_t texel) {
+    if (texel == 0) {
+      return true;
+    }
+    if (mode.subsets == 2) {
+      return texel == BC7_ANCHORS_2[partition];
+    }
+    return mode.subsets == 3 &&
+           (texel == BC7_ANCHORS_3_SECOND[partition] || texel == BC7_ANCHORS_3_THIRD[partition]);
+  };
+
+  std::array<uint32_t, 16> indices;
+  for (uint32_t i = 0; i < 16; i++) {
+    indices[i] = bits.read(mode.index_bits - (isAnchor(i) ? 1 : 0));
+  }
+  // only the single subset modes have secondary indices, so texel 0 is their only anchor
+  std::array<uint32_t, 16> secondary_indices{};
+  if (mode.secondary_index_bits) {
+    for (uint32_t i = 0; i < 16; i++) {
+      secondary_indices[i] = bits.read(mode.secondary_index_bits - (i == 0 ? 1 : 0));
+    }
+  }
+
+  auto getWeight = [](uint32_t index, uint32_t index_bits) -> uint32_t {
+    switch (index_bits) {
+      case 2:
+        return BC7_WEIGHTS_2[index];
+      case 3:
+        return BC7_WEIGHTS_3[index];
+      default:
+        return BC7_WEIGHTS_4[index];
+    }
+  };
+
+  for (uint32_t i = 0; i < 16; i++) {
+    auto& e0 = endpoints[getSubset(i) * 2];
+    auto& e1 = endpoints[getSubset(i) * 2 + 1];
+
+    uint32_t color_weight = getWeight(indices[i], mode.index_bits);
+    uint32_t alpha_weight = color_weight;
+    if (mode.secondary_index_bits) {
+      alpha_weight = getWeight(secondary_indices[i], mode.secondary_index_bits);
+      if (index_selection) {
+        color_weight = alpha_weight;
+        alpha_weight = getWeight(indices[i], mode.index_bits);
+      }
+    }
+
+    uint8_t* texel = &texels[i * 4];
+    for (uint32_t channel = 0; channel < 4; channel++) {
+      uint32_t weight = channel == 3 ? alpha_weight : color_weight;
+      texel[channel] = ((64 - weight) * e0[channel] + weight * e1[channel] + 32) >> 6;
+    }
+    if (rotation) {
+      std::swap(texel[3], texel[rotation - 1]);
+    }
+  }
+}
+}  // namespace
+
+FormatBlock getFormatBlock(vk::Format format) {
+  switch (format) {
+    case vk::Format::eR8G8B8A8Unorm:
+    case vk::Format::eR8G8B8A8Srgb:
+      return {.extent = 1, .size = 4};
+    case vk::Format::eBc1RgbUnormBlock:
+    case vk::Format::eBc1RgbSrgbBlock:
+    case vk::Format::eBc1RgbaUnormBlock:
+    case vk::Format::eBc1RgbaSrgbBlock:
+      return {.extent = 4, .size = 8};
+    case vk::Format::eBc3UnormBlock:
+    case vk::Format::eBc3SrgbBlock:
+    case vk::Format::eBc5UnormBlock:
+    case vk::Format::eBc7UnormBlock:
+    case vk::Format::eBc7SrgbBlock:
+      return {.extent = 4, .size = 16};
+    default:
+      throw std::runtime_error("Unsupported texture format " + vk::to_string(format));
+  }
+}
+
+vk::Format getDecodedFormat(vk::Format format) {
+  switch (format) {
+    case vk::Format::eR8G8B8A8Srgb:
+    case vk::Format::eBc1RgbSrgbBlock:
+    case vk::Format::eBc1RgbaSrgbBlock:
+    case vk::Format::eBc3SrgbBlock:
+    case vk::Format::eBc7SrgbBlock:
+      return vk::Format::eR8G8B8A8Srgb;
+    default:
+      getFormatBlock(format);  // throws for unsupported formats
+      return vk::Format::eR8G8B8A8Unorm;
+  }
+}
+
+std::vector<uint8_t> decodeBlocks(vk::Format format, const uint8_t* blocks, uint32_t width,
+                                  uint32_t height) {
+  auto block_size = getFormatBlock(format).size;
+  if (!isBlockCompressed(format)) {
+    return std::vector<uint8_t>(blocks, blocks + size_t{width} * height * block_size);
+  }
+
+  std::vector<uint8_t> texels(size_t{width} * height * 4);
+  BlockTexels block_texels;
+  for (uint32_t block_y = 0; block_y < (height + 3) / 4; block_y++) {
+    for (uint32_t block_x = 0; block_x < (width + 3) / 4; block_x++, blocks += block_size) {
+      switch (format) {
+        case vk::Format::eBc1RgbUnormBlock:
+        case vk::Format::eBc1RgbSrgbBlock:
+        case vk::Format::eBc1RgbaUnormBlock:
+        case vk::Format::eBc1RgbaSrgbBlock:
+          decodeBc1(blocks, block_texels, false);
+          if (format == vk::Format::eBc1RgbUnormBlock || format == vk::Format::eBc1RgbSrgbBlock) {
+            for (uint32_t i = 0; i < 16; i++) {
+              block_texels[i * 4 + 3] = 255;
+            }
+          }
+          break;
+        case vk::Format::eBc3UnormBlock:
+        case vk::Format::eBc3SrgbBlock:
+          decodeBc1(blocks + 8, block_texels, true);
+          decodeBc4(blocks, &block_texels[3]);
+          break;
+        case vk::Format::eBc5UnormBlock:
+          decodeBc4(blocks, &block_texels[0]);
+          decodeBc4(blocks + 8, &block_texels[1]);
+          for (uint32_t i = 0; i < 16; i++) {
+            block_texels[i * 4 + 2] = 0;
+            block_texels[i * 4 + 3] = 255;
+          }
+          break;
+        default:
+          decodeBc7(blocks, block_texels);
+          break;
+      }
+
+      // blocks at the right and bottom edge may extend past the image
+      for (uint32_t y = 0; y < 4 && block_y * 4 + y < height; y++) {
+        uint32_t row_width = std::min(4u, width - block_x * 4);
+        std::memcpy(&texels[((block_y * 4 + y) * width + block_x * 4) * 4], &block_texels[y * 16],
+                    row_width * 4);
+      }
+    }
+  }
+  return texels;
+}
+
+std::vector<uint8_t> encodeBlocks(vk::Format format, const uint8_t* texels, uint32_t width,
+                                  uint32_t height) {
+  bool alpha;
+  switch (format) {
+    case vk::Format::eBc1RgbUnormBlock:
+    case vk::Format::eBc1RgbSrgbBlock:
+      alpha = false;
+      break;
+    case vk::Format::eBc3UnormBlock:
+    case vk::Format::eBc3SrgbBlock:
+      alpha = true;
+      break;
+    default:
+      throw std::runtime_error("Can't encode texture format " + vk::to_string(format));
+  }
+
+  auto block_size = getFormatBlock(format).size;
+  uint32_t blocks_x = (width + 3) / 4;
+  uint32_t blocks_y = (height + 3) / 4;
+  std::vector<uint8_t> blocks(size_t{blocks_x} * blocks_y * block_size);
+
+  BlockTexels block_texels;
+  uint8_t* block = blocks.data();
+  for (uint32_t block_y = 0; block_y < blocks_y; block_y++) {
+    for (uint32_t block_x = 0; block_x < blocks_x; block_x++, block += block_size) {
+      for (uint32_t y = 0; y < 4; y++) {
+        for (uint32_t x = 0; x < 4; x++) {
+          uint32_t texel_x = std::min(block_x * 4 + x, width - 1);
+          uint32_t texel_y = std::min(block_y * 4 + y, height - 1);
+          std::memcpy(&block_texels[(y * 4 + x) * 4], &texels[(texel_y * width + texel_x) * 4], 4);
+        }
+      }
+      stb_compress_dxt_block(block, block_texels.data(), alpha, STB_DXT_HIGHQUAL);
+    }
+  }
+  return blocks;
+}
+}  // namespace TE
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "tepch.hpp"
+
+namespace TE {
+// Texel blocks of a texture format, uncompressed formats have 1x1 blocks.
+struct FormatBlock {
+  uint32_t extent;  // width and height in texels
+  uint32_t size;    // in bytes
+};
+
+// Throws for formats textures don't support: RGBA8, BC1, BC3, BC5 and BC7.
+FormatBlock getFormatBlock(vk::Format format);
+inline bool isBlockCompressed(vk::Format format) { return getFormatBlock(format).extent > 1; }
+
+// The RGBA8 format decodeBlocks() writes for a block-compressed format, sRGB stays sRGB.
+vk::Format getDecodedFormat(vk::Format format);
+// Decodes the blocks of a width x height image into RGBA8 texels on the CPU, for devices that
+// can't sample the format. BC5 decodes to red and green, blue is 0 and alpha 255.
+std::vector<uint8_t> decodeBlocks(vk::Format format, const uint8_t* blocks, uint32_t width,
+                                  uint32_t height);
+// Encodes the RGBA8 texels of a width x height image into opaque BC1 or BC3 blocks, edge blocks
+// repeat the last row and column. Meant for offline cooking, it is slow.
+std::vector<uint8_t> encodeBlocks(vk::Format format, const uint8_t* texels, uint32_t width,
+                                  uint32_t height);
+}  // namespace TE
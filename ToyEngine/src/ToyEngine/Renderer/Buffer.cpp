@@ -1,5 +1,6 @@
 #include "Buffer.hpp"
 
+#include <utility>
 #include <vulkan/vulkan.hpp>
 
 #include "Allocator.hpp"
@@ -26,11 +27,35 @@ Buffer::Buffer(vk::DeviceSize size, vk::BufferUsageFlags usage, VmaAllocationCre
   }
 }
 
-Buffer::~Buffer() { vmaDestroyBuffer(GraphicsContext::get().getAllocator(), buffer, allocation); }
+Buffer::Buffer(Buffer&& other) noexcept
+    : buffer{std::exchange(other.buffer, VK_NULL_HANDLE)},
+      allocation{std::exchange(other.allocation, VK_NULL_HANDLE)},
+      size{other.size} {}
+
+Buffer& Buffer::operator=(Buffer&& other) noexcept {
+  std::swap(buffer, other.buffer);
+  std::swap(allocation, other.allocation);
+  std::swap(size, other.size);
+  return *this;
+}
+
+Buffer::~Buffer() {
+  if (buffer) {
+    vmaDestroyBuffer(GraphicsContext::get().getAllocator(), buffer, allocation);
+  }
+}
 
 void Buffer::write(const void* data, VkDeviceSize size, VkDeviceSize offset) const {
-  auto err = vmaCopyMemoryToAllocation(GraphicsContext::get().getAllocator(), data, allocation,
-                                       offset, size);
+  auto& ctx = GraphicsContext::get();
+
+  VkMemoryPropertyFlags memory_flags;
+  vmaGetAllocationMemoryProperties(ctx.getAllocator(), allocation, &memory_flags);
+  if (!(memory_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+    ctx.getUploadScheduler().uploadBuffer(data, size, buffer, offset);
+    return;
+  }
+
+  auto err = vmaCopyMemoryToAllocation(ctx.getAllocator(), data, allocation, offset, size);
   if (err != VK_SUCCESS) {
     throw std::runtime_error("Failed to write to buffer");
   }
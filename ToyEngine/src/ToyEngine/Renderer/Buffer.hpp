@@ -8,8 +8,13 @@ namespace TE {
 class Buffer {
  public:
   Buffer(vk::DeviceSize size, vk::BufferUsageFlags usage, VmaAllocationCreateFlags flags);
+  Buffer(const Buffer&) = delete;
+  Buffer(Buffer&& other) noexcept;
+  Buffer& operator=(const Buffer&) = delete;
+  Buffer& operator=(Buffer&& other) noexcept;
   ~Buffer();
 
+  // Device local buffers are written asynchronously through the UploadScheduler.
   void write(const void* data, VkDeviceSize size, VkDeviceSize offset) const;
   void copyTo(Buffer& dst);
 
@@ -52,8 +57,8 @@ class Buffer {
   uint32_t findMemoryType(vk::PhysicalDevice gpu, uint32_t type_filter,
                           vk::MemoryPropertyFlags properties) const;
 
-  VkBuffer buffer;
-  VmaAllocation allocation;
+  VkBuffer buffer = VK_NULL_HANDLE;
+  VmaAllocation allocation = VK_NULL_HANDLE;
   vk::DeviceSize size;
 };
 }  // namespace TE
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "Bvh.hpp"
+
+#include <numeric>
+
+namespace TE {
+namespace {
+enum class Containment {
+  OUTSIDE,
+  INTERSECTING,
+  INSIDE,
+};
+
+Containment classify(const Frustum& frustum, const Aabb& box) {
+  Containment result = Containment::INSIDE;
+  for (auto& plane : frustum.planes) {
+    glm::vec3 normal{plane};
+    // the corners furthest along and against the normal
+    glm::vec3 p = glm::mix(box.min, box.max, glm::greaterThan(normal, glm::vec3(0.0f)));
+    glm::vec3 n = glm::mix(box.max, box.min, glm::greaterThan(normal, glm::vec3(0.0f)));
+    if (glm::dot(normal, p) + plane.w < 0.0f) {
+      return Containment::OUTSIDE;
+    }
+    if (glm::dot(normal, n) + plane.w < 0.0f) {
+      result = Containment::INTERSECTING;
+    }
+  }
+  return result;
+}
+}  // namespace
+
+void Bvh::build(std::span<const Aabb> object_boxes) {
+  uint32_t count = object_boxes.size();
+  order.resize(count);
+  std::iota(order.begin(), order.end(), 0);
+  position.resize(count);
+  leaf.resize(count);
+  boxes.resize(count);
+  scratch.resize(count);
+
+  std::vector<glm::vec3> centroids(count);
+  for (uint32_t i = 0; i < count; i++) {
+    centroids[i] = (object_boxes[i].min + object_boxes[i].max) * 0.5f;
+  }
+  partition(0, count, centroids);
+
+  for (uint32_t i = 0; i < count; i++) {
+    position[order[i]] = i;
+    boxes.set(i, object_boxes[order[i]]);
+  }
+
+  nodes.clear();
+  if (count > 0) {
+    buildNode(0, count, INVALID);
+  }
+  dirty.assign(nodes.size(), 0);
+}
+
+void Bvh::partition(uint32_t first, uint32_t count, const std::vector<glm::vec3>& centroids) {
+  if (count <= LEAF_SIZE) {
+    return;
+  }
+
+  // median split along the largest extent of the centroids
+  glm::vec3 min{std::numeric_limits<float>::max()};
+  glm::vec3 max{std::numeric_limits<float>::lowest()};
+  for (uint32_t i = first; i < first + count; i++) {
+    min = glm::min(min, centroids[order[i]]);
+    max = glm::max(max, centroids[order[i]]);
+  }
+  glm::vec3 extent = max - min;
+  int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+  uint32_t half = count / 2;
+  auto begin = order.begin() + first;
+  std::nth_element(begin, begin + half, begin + count, [&](uint32_t a, uint32_t b) {
+    return centroids[a][axis] < centroids[b][axis];
+  });
+  partition(first, half, centroids);
+  partition(first + half, count - half, centroids);
+}
+
+uint32_t Bvh::buildNode(uint32_t first, uint32_t count, uint32_t parent) {
+  uint32_t index = nodes.size();
+  nodes.push_back({
+      .bounds = computeBounds(first, count),
+      .first = first,
+      .count = count,
+      .parent = parent,
+  });
+
+  if (count <= LEAF_SIZE) {
+    for (uint32_t i = first; i < first + count; i++) {
+      leaf[order[i]] = index;
+    }
+    return index;
+  }
+
+  // same split as partition()
+  uint32_t half = count / 2;
+  buildNode(first, half, index);
+  uint32_t right = buildNode(first + half, count - half, index);
+  nodes[index].right = right;
+  return index;
+}
+
+Aabb Bvh::computeBounds(uint32_t first, uint32_t count) const {
+  Aabb bounds{glm::vec3{std::numeric_limits<float>::max()},
+              glm::vec3{std::numeric_limits<float>::lowest()}};
+  for (uint32_t i = first; i < first + count; i++) {
+    Aabb box = boxes.get(i);
+    bounds.min = glm::min(bounds.min, box.min);
+    bounds.max = glm::max(bounds.max, box.max);
+  }
+  return bounds;
+}
+
+void Bvh::update(uint32_t object, const Aabb& box) {
+  boxes.set(position[object], box);
+  for (uint32_t node = leaf[object]; node != INVALID && !dirty[node];
+       node = nodes[node].parent) {
+    dirty[node] = 1;
+  }
+}
+
+void Bvh::refit() {
+  // children are stored after their parents, a reverse pass sees them refit first
+  for (uint32_t i = nodes.size(); i-- > 0;) {
+    if (!dirty[i]) {
+      continue;
+    }
+    dirty[i] = 0;
+
+    auto& node = nodes[i];
+    if (node.right == INVALID) {
+      node.bounds = computeBounds(node.first, node.count);
+      continue;
+    }
+
+    auto& left = nodes[i + 1].bounds;
+    auto& right = nodes[node.right].bounds;
+    node.bounds = {glm::min(left.min, right.min), glm::max(left.max, right.max)};
+  }
+}
+
+void Bvh::cull(const Frustum& frustum, std::vector<uint8_t>& visible, JobSystem* jobs) {
+  visible.assign(order.size(), 0);
+  if (nodes.empty()) {
+    return;
+  }
+  if (!jobs || order.size() < PARALLEL_OBJECTS) {
+    cullSubtree(frustum, 0, visible);
+    return;
+  }
+
+  // Split the top levels until there are a few subtrees per thread. Subtrees cover disjoint
+  // objects and leaf positions, so they write disjoint parts of visible and scratch.
+  subtrees.assign(1, 0);
+  while (subtrees.size() < jobs->getThreadCount() * 4) {
+    size_t count = subtrees.size();
+    for (size_t i = 0; i < count; i++) {
+      auto& node = nodes[subtrees[i]];
+      if (node.right != INVALID) {
+        subtrees.push_back(node.right);
+        subtrees[i]++;  // left child
+      }
+    }
+    if (subtrees.size() == count) {
+      break;
+    }
+  }
+
+  jobs->parallelFor(subtrees.size(), 1, [&](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; i++) {
+      cullSubtree(frustum, subtrees[i], visible);
+    }
+  });
+}
+
+void Bvh::cullSubtree(const Frustum& frustum, uint32_t root, std::vector<uint8_t>& visible) {
+  uint32_t stack[64];
+  uint32_t stack_size = 0;
+  stack[stack_size++] = root;
+  while (stack_size > 0) {
+    auto& node = nodes[stack[--stack_size]];
+
+    switch (classify(frustum, node.bounds)) {
+      case Containment::OUTSIDE:
+        break;
+      case Containment::INSIDE:
+        for (uint32_t i = node.first; i < node.first + node.count; i++) {
+          visible[order[i]] = 1;
+        }
+        break;
+      case Containment::INTERSECTING:
+        if (node.right == INVALID) {
+          cullAabbsSimd(frustum, boxes, node.first, node.count, scratch.data());
+          for (uint32_t i = node.first; i < node.first + node.count; i++) {
+            visible[order[i]] = scratch[i];
+          }
+        } else {
+          stack[stack_size++] = node.right;
+          stack[stack_size++] = static_cast<uint32_t>(&node - nodes.data()) + 1;
+        }
+        break;
+    }
+  }
+}
+}  // namespace TE
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <span>
+
+#include "ToyEngine/Core/JobSystem.hpp"
+#include "ToyEngine/Renderer/FrustumCulling.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Binary bounding volume hierarchy over object boxes for CPU frustum culling. Every subtree covers
+// a contiguous range of the leaf-ordered boxes, so subtrees fully inside the frustum are accepted
+// without testing their objects and partially visible leaves are tested with the SIMD kernel.
+// Moving objects only refits the nodes above them, rebuild when the set of objects changes.
+class Bvh {
+ public:
+  void build(std::span<const Aabb> boxes);
+  // Updates the box of an object, applied to the hierarchy by refit().
+  void update(uint32_t object, const Aabb& box);
+  void refit();
+
+  // Sets visible[object] to 1 for every object intersecting the frustum and 0 for all others.
+  // With a job system the subtrees below the top levels are culled in parallel.
+  void cull(const Frustum& frustum, std::vector<uint8_t>& visible, JobSystem* jobs = nullptr);
+
+  inline size_t size() const { return order.size(); }
+
+  static constexpr uint32_t LEAF_SIZE = 8;
+  static constexpr uint32_t PARALLEL_OBJECTS = 16 * 1024;
+
+ private:
+  static constexpr uint32_t INVALID = UINT32_MAX;
+
+  struct Node {
+    Aabb bounds;
+    uint32_t first;  // range of leaf-ordered boxes covered by the subtree
+    uint32_t count;
+    uint32_t right = INVALID;  // the left child directly follows its parent, leaves have none
+    uint32_t parent = INVALID;
+  };
+
+  void partition(uint32_t first, uint32_t count, const std::vector<glm::vec3>& centroids);
+  uint32_t buildNode(uint32_t first, uint32_t count, uint32_t parent);
+  Aabb computeBounds(uint32_t first, uint32_t count) const;
+  void cullSubtree(const Frustum& frustum, uint32_t root, std::vector<uint8_t>& visible);
+
+  std::vector<Node> nodes;
+  std::vector<uint8_t> dirty;      // per node
+  AabbSoA boxes;                   // in leaf order
+  std::vector<uint32_t> order;     // leaf position -> object
+  std::vector<uint32_t> position;  // object -> leaf position
+  std::vector<uint32_t> leaf;      // object -> leaf node
+  std::vector<uint8_t> scratch;    // per leaf position results of the SIMD test
+  std::vector<uint32_t> subtrees;  // culled in parallel
+};
+}  // namespace TE
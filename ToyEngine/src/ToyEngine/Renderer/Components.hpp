@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ToyEngine/Renderer/PipelineBuilder.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Mesh drawn by the Scene that created the entity.
+struct MeshRenderer {
+  uint32_t mesh;  // id in the scene's geometry pool
+  uint32_t texture;
+  const GraphicsPipeline* pipeline;  // null draws with the pass default
+  uint32_t object;                   // the entity's bounding box in the scene's BVH
+};
+
+// Node of the entity in the scene's TransformHierarchy.
+struct TransformNode {
+  uint32_t node;
+};
+}  // namespace TE
@@ -38,13 +38,16 @@ bool validateExtensions(const std::vector<const char*>& required,
   });
 }
 
-std::vector<const char*> getRequiredInstanceExtensions() {
-  // glfw extensions
-  uint32_t glfw_extension_count = 0;
-  const char** glfw_extensions;
-  glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+std::vector<const char*> getRequiredInstanceExtensions(bool headless) {
+  std::vector<const char*> extensions;
 
-  std::vector<const char*> extensions(glfw_extensions, glfw_extensions + glfw_extension_count);
+  // glfw extensions
+  if (!headless) {
+    uint32_t glfw_extension_count = 0;
+    const char** glfw_extensions;
+    glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+    extensions.assign(glfw_extensions, glfw_extensions + glfw_extension_count);
+  }
 
 #ifdef ENABLE_VALIDATION_LAYERS
   extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -59,8 +62,10 @@ Device::Device(GLFWwindow* window) {
   // initialize function pointers
   VULKAN_HPP_DEFAULT_DISPATCHER.init();
 
-  createInstance();
-  createSurface(window);
+  createInstance(window == nullptr);
+  if (window) {
+    createSurface(window);
+  }
   pickPhysicalDevice();
   createLogicalDevice();
 }
@@ -81,7 +86,7 @@ Device::~Device() {
   instance.destroy();
 }
 
-void Device::createInstance() {
+void Device::createInstance(bool headless) {
 #ifdef ENABLE_VALIDATION_LAYERS
   if (!validateLayers()) {
     throw std::runtime_error("Validation layers requested, but not available.");
@@ -97,7 +102,7 @@ void Device::createInstance() {
       .apiVersion = VK_API_VERSION_1_3,
   };
 
-  auto extensions = getRequiredInstanceExtensions();
+  auto extensions = getRequiredInstanceExtensions(headless);
   auto available_extensions = vk::enumerateInstanceExtensionProperties();
   if (!validateExtensions(extensions, available_extensions)) {
     throw std::runtime_error("Required instance extensions are missing.");
@@ -163,7 +168,8 @@ void Device::pickPhysicalDevice() {
     }
 
     for (uint32_t j = 0; j < static_cast<uint32_t>(queue_family_properties.size()); j++) {
-      auto supports_present = physical_device.getSurfaceSupportKHR(j, surface);
+      // headless contexts never present, so any graphics queue will do
+      auto supports_present = !surface || physical_device.getSurfaceSupportKHR(j, surface);
 
       if ((queue_family_properties[j].queueFlags & vk::QueueFlagBits::eGraphics) &&
           supports_present) {
@@ -178,42 +184,83 @@ void Device::pickPhysicalDevice() {
     throw std::runtime_error("Did not find suitable GPU.");
   }
 
-  properties = physical_device.getProperties();
+  // prefer a transfer-only queue family, those map to the GPU's copy engines
+  transfer_queue_index = graphics_queue_index;
+  auto queue_family_properties = physical_device.getQueueFamilyProperties();
+  for (uint32_t i = 0; i < static_cast<uint32_t>(queue_family_properties.size()); i++) {
+    auto flags = queue_family_properties[i].queueFlags;
+    if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & vk::QueueFlagBits::eGraphics) &&
+        !(flags & vk::QueueFlagBits::eCompute)) {
+      transfer_queue_index = i;
+      break;
+    }
+  }
+
+  auto properties_chain = physical_device.getProperties2<
+      vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingProperties>();
+  properties = properties_chain.get<vk::PhysicalDeviceProperties2>().properties;
+  descriptor_indexing_properties =
+      properties_chain.get<vk::PhysicalDeviceDescriptorIndexingProperties>();
 }
 
 void Device::createLogicalDevice() {
-  std::vector<const char*> extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  std::vector<const char*> extensions;
+  if (!isHeadless()) {
+    extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+  }
   auto device_extensions = physical_device.enumerateDeviceExtensionProperties();
   if (!validateExtensions(extensions, device_extensions)) {
     throw std::runtime_error("Required device extensions are missing.");
   }
 
+  // optional, lets the GPU decide how many indirect draws to execute
+  draw_indirect_count = validateExtensions({VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME},
+                                           device_extensions);
+  if (draw_indirect_count) {
+    extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+  }
+
   float queue_priority = 1.0f;
-  vk::DeviceQueueCreateInfo queue_info{
+  std::vector<vk::DeviceQueueCreateInfo> queue_infos{{
       .queueFamilyIndex = graphics_queue_index,
       .queueCount = 1,
       .pQueuePriorities = &queue_priority,
-  };
+  }};
+  if (transfer_queue_index != graphics_queue_index) {
+    queue_infos.push_back({
+        .queueFamilyIndex = transfer_queue_index,
+        .queueCount = 1,
+        .pQueuePriorities = &queue_priority,
+    });
+  }
 
   vk::PhysicalDeviceFeatures device_features{};
-  vk::PhysicalDeviceDescriptorIndexingFeatures descriptor_indexing_features{};
+  vk::PhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features{};
+  vk::PhysicalDeviceDescriptorIndexingFeatures descriptor_indexing_features{
+      .pNext = &timeline_semaphore_features,
+  };
   vk::PhysicalDeviceFeatures2 device_features_2{
       .pNext = &descriptor_indexing_features,
       .features = device_features,
   };
   physical_device.getFeatures2(&device_features_2);
   assert(device_features_2.features.samplerAnisotropy);
+  assert(device_features_2.features.multiDrawIndirect);
+  assert(device_features_2.features.drawIndirectFirstInstance);
   assert(descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing);
   assert(descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind);
   assert(descriptor_indexing_features.shaderUniformBufferArrayNonUniformIndexing);
   assert(descriptor_indexing_features.descriptorBindingUniformBufferUpdateAfterBind);
   assert(descriptor_indexing_features.shaderStorageBufferArrayNonUniformIndexing);
   assert(descriptor_indexing_features.descriptorBindingStorageBufferUpdateAfterBind);
+  assert(descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending);
+  assert(descriptor_indexing_features.descriptorBindingPartiallyBound);
+  assert(timeline_semaphore_features.timelineSemaphore);
 
   vk::DeviceCreateInfo device_info{
       .pNext = &device_features_2,
-      .queueCreateInfoCount = 1,
-      .pQueueCreateInfos = &queue_info,
+      .queueCreateInfoCount = static_cast<uint32_t>(queue_infos.size()),
+      .pQueueCreateInfos = queue_infos.data(),
       .enabledExtensionCount = static_cast<uint32_t>(extensions.size()),
       .ppEnabledExtensionNames = extensions.data(),
   };
@@ -223,6 +270,7 @@ void Device::createLogicalDevice() {
   VULKAN_HPP_DEFAULT_DISPATCHER.init(logical_device);
 
   queue = logical_device.getQueue(graphics_queue_index, 0);
+  transfer_queue = logical_device.getQueue(transfer_queue_index, 0);
 }
 
 }  // namespace TE
\ No newline at end of file
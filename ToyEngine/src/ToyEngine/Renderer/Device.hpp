@@ -2,11 +2,13 @@
 
 #include <GLFW/glfw3.h>
 
+#include <mutex>
 #include <vulkan/vulkan.hpp>
 
 namespace TE {
 class Device {
  public:
+  // Passing no window creates a headless device without surface and swapchain support.
   Device(GLFWwindow* window);
   ~Device();
 
@@ -16,10 +18,24 @@ class Device {
   inline vk::Device getDevice() const { return logical_device; }
   inline vk::Queue getQueue() const { return queue; }
   inline uint32_t getGraphicsQueueIndex() const { return graphics_queue_index; }
+  // Falls back to the graphics queue if the GPU has no dedicated transfer queue family.
+  inline vk::Queue getTransferQueue() const { return transfer_queue; }
+  inline uint32_t getTransferQueueIndex() const { return transfer_queue_index; }
+  inline bool hasDedicatedTransferQueue() const {
+    return transfer_queue_index != graphics_queue_index;
+  }
   inline const vk::PhysicalDeviceProperties& getProperties() const { return properties; }
+  inline const vk::PhysicalDeviceDescriptorIndexingProperties& getDescriptorIndexingProperties()
+      const {
+    return descriptor_indexing_properties;
+  }
+  // Guards both queues, submissions may come from the render thread and the simulation at once.
+  inline std::mutex& getQueueMutex() const { return queue_mutex; }
+  inline bool isHeadless() const { return !surface; }
+  inline bool supportsDrawIndirectCount() const { return draw_indirect_count; }
 
  private:
-  void createInstance();
+  void createInstance(bool headless);
   void createSurface(GLFWwindow* window);
   void pickPhysicalDevice();
   void createLogicalDevice();
@@ -29,8 +45,13 @@ class Device {
   vk::PhysicalDevice physical_device;
   vk::Device logical_device;
   vk::Queue queue;
+  vk::Queue transfer_queue;
+  mutable std::mutex queue_mutex;
   vk::DebugUtilsMessengerEXT debug_messenger;
   uint32_t graphics_queue_index;
+  uint32_t transfer_queue_index;
+  bool draw_indirect_count = false;
   vk::PhysicalDeviceProperties properties;
+  vk::PhysicalDeviceDescriptorIndexingProperties descriptor_indexing_properties;
 };
 }  // namespace TE
\ No newline at end of file
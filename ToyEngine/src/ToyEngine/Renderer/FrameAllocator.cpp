@@ -0,0 +1,63 @@
+#include "FrameAllocator.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+namespace TE {
+FrameAllocator::FrameAllocator(VmaAllocator allocator, BindlessRegistry& bindless,
+                               vk::DeviceSize frame_size, uint32_t frame_count)
+    : allocator{allocator}, frame_size{frame_size} {
+  vk::BufferCreateInfo buffer_info{
+      .size = frame_size * frame_count,
+      .usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eUniformBuffer |
+               vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferSrc,
+      .sharingMode = vk::SharingMode::eExclusive,
+  };
+
+  VmaAllocationCreateInfo alloc_info{};
+  alloc_info.usage = VMA_MEMORY_USAGE_AUTO;
+  alloc_info.flags =
+      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+  VmaAllocationInfo info;
+  auto err = vmaCreateBuffer(allocator, (VkBufferCreateInfo*)&buffer_info, &alloc_info, &buffer,
+                             &allocation, &info);
+  if (err != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create frame allocator buffer");
+  }
+  mapped = static_cast<std::byte*>(info.pMappedData);
+
+  for (uint32_t i = 0; i < frame_count; i++) {
+    descriptors.push_back(bindless.registerStorageBuffer({
+        .buffer = buffer,
+        .offset = i * frame_size,
+        .range = frame_size,
+    }));
+  }
+}
+
+FrameAllocator::~FrameAllocator() { vmaDestroyBuffer(allocator, buffer, allocation); }
+
+void FrameAllocator::beginFrame(uint32_t frame) {
+  this->frame = frame;
+  head = 0;
+}
+
+void FrameAllocator::endFrame() {
+  if (head > 0) {
+    vmaFlushAllocation(allocator, allocation, frame * frame_size, head);
+  }
+}
+
+FrameAllocation FrameAllocator::allocate(vk::DeviceSize size, vk::DeviceSize alignment) {
+  vk::DeviceSize offset = (head + alignment - 1) / alignment * alignment;
+  if (offset + size > frame_size) {
+    throw std::runtime_error("Frame allocator out of memory");
+  }
+
+  head = offset + size;
+  return {
+      .data = mapped + frame * frame_size + offset,
+      .offset = offset,
+  };
+}
+}  // namespace TE
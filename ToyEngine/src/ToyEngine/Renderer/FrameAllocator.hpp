@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/Allocator.hpp"
+#include "ToyEngine/Renderer/BindlessRegistry.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+struct FrameAllocation {
+  void* data;
+  vk::DeviceSize offset;  // relative to the frame's buffer range
+};
+
+// Linear allocator for per-frame data like object constants. Every frame in flight owns a
+// separate range of one persistently mapped buffer, so writing the current frame never races
+// with the GPU reading the previous one. Each range is registered as a bindless storage buffer.
+class FrameAllocator {
+ public:
+  FrameAllocator(VmaAllocator allocator, BindlessRegistry& bindless, vk::DeviceSize frame_size,
+                 uint32_t frame_count);
+  ~FrameAllocator();
+
+  void beginFrame(uint32_t frame);
+  // Flushes the data written this frame for non-coherent memory.
+  void endFrame();
+
+  // alignment does not need to be a power of two
+  FrameAllocation allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+  // offset / sizeof(T) of the allocation indexes an array of T in the shader
+  template <typename T>
+  inline FrameAllocation allocate(size_t count) {
+    return allocate(sizeof(T) * count, sizeof(T));
+  }
+
+  inline vk::Buffer getBuffer() const { return buffer; }
+  // offset of the current frame's range in the buffer, e.g. for indirect draws or copies
+  inline vk::DeviceSize getFrameOffset() const { return frame * frame_size; }
+  inline vk::DeviceSize getFrameSize() const { return frame_size; }
+  // storage buffer of the current frame's range
+  inline StorageBufferHandle getDescriptor() const { return descriptors[frame]; }
+
+ private:
+  VmaAllocator allocator;
+  VkBuffer buffer;
+  VmaAllocation allocation;
+  std::byte* mapped;
+  vk::DeviceSize frame_size;
+  std::vector<StorageBufferHandle> descriptors;
+  uint32_t frame = 0;
+  vk::DeviceSize head = 0;
+};
+}  // namespace TE
@@ -0,0 +1,70 @@
+#include "FreeListAllocator.hpp"
+
+#include <cassert>
+
+namespace TE {
+FreeListAllocator::FreeListAllocator(uint32_t capacity) : capacity{capacity} {
+  if (capacity > 0) {
+    free_blocks.emplace(0, capacity);
+  }
+}
+
+std::optional<uint32_t> FreeListAllocator::allocate(uint32_t size) {
+  if (size == 0) {
+    return 0;
+  }
+
+  for (auto it = free_blocks.begin(); it != free_blocks.end(); it++) {
+    auto [offset, block_size] = *it;
+    if (block_size < size) {
+      continue;
+    }
+
+    free_blocks.erase(it);
+    if (block_size > size) {
+      free_blocks.emplace(offset + size, block_size - size);
+    }
+    used += size;
+    return offset;
+  }
+
+  return std::nullopt;
+}
+
+void FreeListAllocator::free(uint32_t offset, uint32_t size) {
+  if (size == 0) {
+    return;
+  }
+  assert(offset + size <= capacity);
+  used -= size;
+
+  auto next = free_blocks.lower_bound(offset);
+  assert(next == free_blocks.end() || next->first >= offset + size);
+
+  // merge with the following block
+  if (next != free_blocks.end() && next->first == offset + size) {
+    size += next->second;
+    next = free_blocks.erase(next);
+  }
+
+  // merge with the preceding block
+  if (next != free_blocks.begin()) {
+    auto prev = std::prev(next);
+    assert(prev->first + prev->second <= offset);
+    if (prev->first + prev->second == offset) {
+      prev->second += size;
+      return;
+    }
+  }
+
+  free_blocks.emplace_hint(next, offset, size);
+}
+
+uint32_t FreeListAllocator::getLargestFreeBlock() const {
+  uint32_t largest = 0;
+  for (auto& [offset, size] : free_blocks) {
+    largest = std::max(largest, size);
+  }
+  return largest;
+}
+}  // namespace TE
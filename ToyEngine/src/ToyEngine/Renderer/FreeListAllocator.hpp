@@ -0,0 +1,27 @@
+#pragma once
+
+#include <map>
+#include <optional>
+
+#include "tepch.hpp"
+
+namespace TE {
+// First-fit allocator over an abstract range of elements. Free blocks are kept sorted by offset
+// and coalesced with their neighbours when released.
+class FreeListAllocator {
+ public:
+  FreeListAllocator(uint32_t capacity);
+
+  std::optional<uint32_t> allocate(uint32_t size);
+  void free(uint32_t offset, uint32_t size);
+
+  inline uint32_t getCapacity() const { return capacity; }
+  inline uint32_t getUsed() const { return used; }
+  uint32_t getLargestFreeBlock() const;
+
+ private:
+  uint32_t capacity;
+  uint32_t used = 0;
+  std::map<uint32_t, uint32_t> free_blocks;  // offset -> size
+};
+}  // namespace TE
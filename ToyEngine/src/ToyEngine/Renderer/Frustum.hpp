@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+
+namespace TE {
+struct Aabb {
+  glm::vec3 min;
+  glm::vec3 max;
+};
+
+// Planes of a view frustum with normals pointing inwards, in the space the view projection
+// matrix transforms from.
+struct Frustum {
+  std::array<glm::vec4, 6> planes;
+
+  inline Frustum(const glm::mat4& view_projection) {
+    auto row = [&](int i) {
+      return glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i],
+                       view_projection[3][i]);
+    };
+
+    planes = {
+        row(3) + row(0),  // left
+        row(3) - row(0),  // right
+        row(3) + row(1),  // bottom
+        row(3) - row(1),  // top
+        row(2),           // near, depth is in [0, 1]
+        row(3) - row(2),  // far
+    };
+    for (auto& plane : planes) {
+      plane /= glm::length(glm::vec3(plane));
+    }
+  }
+
+  inline bool intersectsSphere(const glm::vec3& center, float radius) const {
+    for (auto& plane : planes) {
+      if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// Transforms a local bounding sphere (xyz center, w radius), scaling the radius by the largest
+// axis scale.
+inline glm::vec4 transformSphere(const glm::mat4& world, const glm::vec4& sphere) {
+  glm::vec3 center{world * glm::vec4(glm::vec3(sphere), 1.0f)};
+  float scale = glm::max(glm::max(glm::dot(glm::vec3(world[0]), glm::vec3(world[0])),
+                                  glm::dot(glm::vec3(world[1]), glm::vec3(world[1]))),
+                         glm::dot(glm::vec3(world[2]), glm::vec3(world[2])));
+  return glm::vec4(center, sphere.w * glm::sqrt(scale));
+}
+
+// Bounds of the transformed box, computed from its center and extents.
+inline Aabb transformAabb(const glm::mat4& world, const Aabb& box) {
+  glm::vec3 center{world * glm::vec4((box.min + box.max) * 0.5f, 1.0f)};
+  glm::vec3 extent = (box.max - box.min) * 0.5f;
+  glm::vec3 world_extent = glm::abs(glm::vec3(world[0])) * extent.x +
+                           glm::abs(glm::vec3(world[1])) * extent.y +
+                           glm::abs(glm::vec3(world[2])) * extent.z;
+  return {center - world_extent, center + world_extent};
+}
+}  // namespace TE
@@ -0,0 +1,120 @@
+#include "FrustumCulling.hpp"
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace TE {
+namespace {
+// Per plane the box corner furthest along the normal (the p-vertex) decides whether the box is
+// completely outside. Picking it per plane instead of per box keeps the inner loop branch free.
+struct PlaneCorner {
+  const float* x;
+  const float* y;
+  const float* z;
+};
+
+inline PlaneCorner selectCorner(const glm::vec4& plane, const AabbSoA& boxes) {
+  return {
+      plane.x > 0.0f ? boxes.max_x.data() : boxes.min_x.data(),
+      plane.y > 0.0f ? boxes.max_y.data() : boxes.min_y.data(),
+      plane.z > 0.0f ? boxes.max_z.data() : boxes.min_z.data(),
+  };
+}
+}  // namespace
+
+void cullAabbsScalar(const Frustum& frustum, const AabbSoA& boxes, size_t first, size_t count,
+                     uint8_t* visible) {
+  std::array<PlaneCorner, 6> corners;
+  for (size_t p = 0; p < 6; p++) {
+    corners[p] = selectCorner(frustum.planes[p], boxes);
+  }
+
+  for (size_t i = first; i < first + count; i++) {
+    bool inside = true;
+    for (size_t p = 0; p < 6; p++) {
+      auto& plane = frustum.planes[p];
+      float distance = plane.x * corners[p].x[i] + plane.y * corners[p].y[i] +
+                       plane.z * corners[p].z[i] + plane.w;
+      inside &= distance >= 0.0f;
+    }
+    visible[i] = inside;
+  }
+}
+
+void cullAabbsSimd(const Frustum& frustum, const AabbSoA& boxes, size_t first, size_t count,
+                   uint8_t* visible) {
+  size_t i = first;
+  size_t end = first + count;
+
+#if defined(__AVX__)
+  constexpr size_t WIDTH = 8;
+  std::array<PlaneCorner, 6> corners;
+  __m256 nx[6], ny[6], nz[6], nw[6];
+  for (size_t p = 0; p < 6; p++) {
+    corners[p] = selectCorner(frustum.planes[p], boxes);
+    nx[p] = _mm256_set1_ps(frustum.planes[p].x);
+    ny[p] = _mm256_set1_ps(frustum.planes[p].y);
+    nz[p] = _mm256_set1_ps(frustum.planes[p].z);
+    nw[p] = _mm256_set1_ps(frustum.planes[p].w);
+  }
+
+  const __m256 zero = _mm256_setzero_ps();
+  for (; i + WIDTH <= end; i += WIDTH) {
+    __m256 outside = zero;
+    for (size_t p = 0; p < 6; p++) {
+      __m256 distance = _mm256_mul_ps(nx[p], _mm256_loadu_ps(corners[p].x + i));
+      distance = _mm256_add_ps(distance, _mm256_mul_ps(ny[p], _mm256_loadu_ps(corners[p].y + i)));
+      distance = _mm256_add_ps(distance, _mm256_mul_ps(nz[p], _mm256_loadu_ps(corners[p].z + i)));
+      distance = _mm256_add_ps(distance, nw[p]);
+      outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+    }
+
+    int mask = _mm256_movemask_ps(outside);
+    for (size_t lane = 0; lane < WIDTH; lane++) {
+      visible[i + lane] = !((mask >> lane) & 1);
+    }
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  constexpr size_t WIDTH = 4;
+  std::array<PlaneCorner, 6> corners;
+  __m128 nx[6], ny[6], nz[6], nw[6];
+  for (size_t p = 0; p < 6; p++) {
+    corners[p] = selectCorner(frustum.planes[p], boxes);
+    nx[p] = _mm_set1_ps(frustum.planes[p].x);
+    ny[p] = _mm_set1_ps(frustum.planes[p].y);
+    nz[p] = _mm_set1_ps(frustum.planes[p].z);
+    nw[p] = _mm_set1_ps(frustum.planes[p].w);
+  }
+
+  const __m128 zero = _mm_setzero_ps();
+  for (; i + WIDTH <= end; i += WIDTH) {
+    __m128 outside = zero;
+    for (size_t p = 0; p < 6; p++) {
+      __m128 distance = _mm_mul_ps(nx[p], _mm_loadu_ps(corners[p].x + i));
+      distance = _mm_add_ps(distance, _mm_mul_ps(ny[p], _mm_loadu_ps(corners[p].y + i)));
+      distance = _mm_add_ps(distance, _mm_mul_ps(nz[p], _mm_loadu_ps(corners[p].z + i)));
+      distance = _mm_add_ps(distance, nw[p]);
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+    }
+
+    int mask = _mm_movemask_ps(outside);
+    for (size_t lane = 0; lane < WIDTH; lane++) {
+      visible[i + lane] = !((mask >> lane) & 1);
+    }
+  }
+#endif
+
+  cullAabbsScalar(frustum, boxes, i, end - i, visible);
+}
+
+const char* getCullingSimdName() {
+#if defined(__AVX__)
+  return "AVX";
+#elif defined(__SSE2__) || defined(_M_X64)
+  return "SSE";
+#else
+  return "scalar";
+#endif
+}
+}  // namespace TE
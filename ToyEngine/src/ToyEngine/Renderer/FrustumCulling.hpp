@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ToyEngine/Renderer/Frustum.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Boxes as structure of arrays, so SIMD lanes load the same component of consecutive boxes.
+struct AabbSoA {
+  std::vector<float> min_x, min_y, min_z;
+  std::vector<float> max_x, max_y, max_z;
+
+  inline size_t size() const { return min_x.size(); }
+
+  inline void resize(size_t count) {
+    for (auto* component : {&min_x, &min_y, &min_z, &max_x, &max_y, &max_z}) {
+      component->resize(count);
+    }
+  }
+
+  inline void set(size_t i, const Aabb& box) {
+    min_x[i] = box.min.x;
+    min_y[i] = box.min.y;
+    min_z[i] = box.min.z;
+    max_x[i] = box.max.x;
+    max_y[i] = box.max.y;
+    max_z[i] = box.max.z;
+  }
+
+  inline Aabb get(size_t i) const {
+    return {{min_x[i], min_y[i], min_z[i]}, {max_x[i], max_y[i], max_z[i]}};
+  }
+};
+
+// Both write visible[i] for every box i in [first, first + count): 1 if the box intersects the
+// frustum, 0 otherwise. The SIMD version tests eight (AVX) or four (SSE) boxes per instruction
+// and falls back to the scalar loop for the remainder or on other architectures.
+void cullAabbsScalar(const Frustum& frustum, const AabbSoA& boxes, size_t first, size_t count,
+                     uint8_t* visible);
+void cullAabbsSimd(const Frustum& frustum, const AabbSoA& boxes, size_t first, size_t count,
+                   uint8_t* visible);
+
+// "AVX", "SSE" or "scalar", the instruction set cullAabbsSimd() was compiled for
+const char* getCullingSimdName();
+}  // namespace TE
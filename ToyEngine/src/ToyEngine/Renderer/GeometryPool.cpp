@@ -0,0 +1,235 @@
+#include "GeometryPool.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/GraphicsContext.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+namespace {
+Aabb computeBoundingBox(std::span<const GeometryPool::VertexType> vertices) {
+  if (vertices.empty()) {
+    return {glm::vec3(0.0f), glm::vec3(0.0f)};
+  }
+
+  Aabb box{vertices[0].pos, vertices[0].pos};
+  for (auto& vertex : vertices) {
+    box.min = glm::min(box.min, vertex.pos);
+    box.max = glm::max(box.max, vertex.pos);
+  }
+  return box;
+}
+
+glm::vec4 computeBoundingSphere(std::span<const GeometryPool::VertexType> vertices,
+                                const Aabb& box) {
+  glm::vec3 center = (box.min + box.max) * 0.5f;
+  float radius = 0.0f;
+  for (auto& vertex : vertices) {
+    radius = glm::max(radius, glm::distance(center, vertex.pos));
+  }
+  return glm::vec4(center, radius);
+}
+}  // namespace
+
+GeometryPool::GeometryPool(uint32_t vertex_capacity, uint32_t index_capacity)
+    : vertex_buffer{createVertexBuffer(vertex_capacity)},
+      index_buffer{createIndexBuffer(index_capacity)},
+      vertex_allocator{vertex_capacity},
+      index_allocator{index_capacity} {}
+
+uint32_t GeometryPool::add(std::span<const VertexType> vertices,
+                           std::span<const IndexType> indices) {
+  uint32_t vertex_count = vertices.size();
+  uint32_t index_count = indices.size();
+
+  auto vertex_offset = vertex_allocator.allocate(vertex_count);
+  auto first_index = index_allocator.allocate(index_count);
+  if (!vertex_offset || !first_index) {
+    if (vertex_offset) {
+      vertex_allocator.free(*vertex_offset, vertex_count);
+    }
+    if (first_index) {
+      index_allocator.free(*first_index, index_count);
+    }
+
+    // grow and pack, the new mesh goes behind the relocated ones
+    uint32_t vertex_capacity = vertex_allocator.getCapacity();
+    if (vertex_allocator.getUsed() + vertex_count > vertex_capacity) {
+      vertex_capacity = std::max(vertex_capacity * 2, vertex_allocator.getUsed() + vertex_count);
+    }
+    uint32_t index_capacity = index_allocator.getCapacity();
+    if (index_allocator.getUsed() + index_count > index_capacity) {
+      index_capacity = std::max(index_capacity * 2, index_allocator.getUsed() + index_count);
+    }
+    relocate(vertex_capacity, index_capacity);
+
+    vertex_offset = vertex_allocator.allocate(vertex_count);
+    first_index = index_allocator.allocate(index_count);
+    assert(vertex_offset && first_index);
+  }
+
+  MeshRange range{
+      .first_index = *first_index,
+      .index_count = index_count,
+      .vertex_offset = static_cast<int32_t>(*vertex_offset),
+      .vertex_count = vertex_count,
+  };
+
+  vertex_buffer.write(vertices.data(), sizeof(VertexType) * vertex_count,
+                      sizeof(VertexType) * *vertex_offset);
+  index_buffer.write(indices.data(), sizeof(IndexType) * index_count,
+                     sizeof(IndexType) * *first_index);
+
+  Aabb box = computeBoundingBox(vertices);
+  if (!free_meshes.empty()) {
+    uint32_t mesh = free_meshes.back();
+    free_meshes.pop_back();
+    meshes[mesh] = range;
+    boxes[mesh] = box;
+    bounds[mesh] = computeBoundingSphere(vertices, box);
+    return mesh;
+  }
+
+  meshes.push_back(range);
+  boxes.push_back(box);
+  bounds.push_back(computeBoundingSphere(vertices, box));
+  return meshes.size() - 1;
+}
+
+void GeometryPool::remove(uint32_t mesh) {
+  removed.push_back({.mesh = mesh, .frame = frame + 1});
+}
+
+void GeometryPool::release(uint32_t mesh) {
+  auto& range = meshes[mesh];
+  vertex_allocator.free(range.vertex_offset, range.vertex_count);
+  index_allocator.free(range.first_index, range.index_count);
+  range = {};
+  free_meshes.push_back(mesh);
+}
+
+void GeometryPool::compact() {
+  relocate(vertex_allocator.getCapacity(), index_allocator.getCapacity());
+}
+
+void GeometryPool::relocate(uint32_t vertex_capacity, uint32_t index_capacity) {
+  // read by the frames recorded before and by the copies handed out by the next flush
+  retired.push_back({
+      .vertex_buffer = std::exchange(vertex_buffer, createVertexBuffer(vertex_capacity)),
+      .index_buffer = std::exchange(index_buffer, createIndexBuffer(index_capacity)),
+      .frame = frame + 1,
+  });
+  // only the old buffers hold removed meshes, which the frames recorded before keep alive
+  for (auto& mesh : removed) {
+    release(mesh.mesh);
+  }
+  removed.clear();
+
+  Relocation relocation{
+      .src_vertex_buffer = retired.back().vertex_buffer.getBuffer(),
+      .src_index_buffer = retired.back().index_buffer.getBuffer(),
+      .dst_vertex_buffer = vertex_buffer.getBuffer(),
+      .dst_index_buffer = index_buffer.getBuffer(),
+  };
+  vertex_allocator = FreeListAllocator{vertex_capacity};
+  index_allocator = FreeListAllocator{index_capacity};
+
+  for (auto& range : meshes) {
+    if (range.vertex_count == 0 && range.index_count == 0) {
+      continue;
+    }
+
+    uint32_t vertex_offset = *vertex_allocator.allocate(range.vertex_count);
+    uint32_t first_index = *index_allocator.allocate(range.index_count);
+    relocation.vertex_copies.push_back({
+        .srcOffset = sizeof(VertexType) * static_cast<uint32_t>(range.vertex_offset),
+        .dstOffset = sizeof(VertexType) * vertex_offset,
+        .size = sizeof(VertexType) * range.vertex_count,
+    });
+    relocation.index_copies.push_back({
+        .srcOffset = sizeof(IndexType) * range.first_index,
+        .dstOffset = sizeof(IndexType) * first_index,
+        .size = sizeof(IndexType) * range.index_count,
+    });
+
+    range.vertex_offset = static_cast<int32_t>(vertex_offset);
+    range.first_index = first_index;
+  }
+
+  relocations.push_back(std::move(relocation));
+}
+
+std::vector<GeometryPool::Relocation> GeometryPool::flush() {
+  frame++;
+
+  // the frames recorded before a relocation may still read the old buffers
+  std::erase_if(retired, [&](const Retired& buffers) {
+    return buffers.frame + GraphicsContext::MAX_FRAMES_QUEUED < frame;
+  });
+  std::erase_if(removed, [&](const Removed& mesh) {
+    if (mesh.frame + GraphicsContext::MAX_FRAMES_QUEUED < frame) {
+      release(mesh.mesh);
+      return true;
+    }
+    return false;
+  });
+
+  return std::exchange(relocations, {});
+}
+
+void GeometryPool::record(vk::CommandBuffer cmd, std::span<const Relocation> relocations) {
+  // relocations are chained, each one reads the result of the previous
+  for (auto& relocation : relocations) {
+    if (!relocation.vertex_copies.empty()) {
+      cmd.copyBuffer(relocation.src_vertex_buffer, relocation.dst_vertex_buffer,
+                     relocation.vertex_copies);
+    }
+    if (!relocation.index_copies.empty()) {
+      cmd.copyBuffer(relocation.src_index_buffer, relocation.dst_index_buffer,
+                     relocation.index_copies);
+    }
+
+    vk::MemoryBarrier barrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eTransferRead |
+                         vk::AccessFlagBits::eVertexAttributeRead |
+                         vk::AccessFlagBits::eIndexRead,
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                        vk::PipelineStageFlagBits::eTransfer |
+                            vk::PipelineStageFlagBits::eVertexInput,
+                        {}, barrier, nullptr, nullptr);
+  }
+}
+
+void GeometryPool::bind(vk::CommandBuffer cmd, vk::Buffer vertex_buffer, vk::Buffer index_buffer) {
+  cmd.bindVertexBuffers(0, vertex_buffer, {0});
+  cmd.bindIndexBuffer(index_buffer, 0, INDEX_TYPE);
+}
+
+float GeometryPool::getFragmentation() const {
+  uint32_t free = vertex_allocator.getCapacity() - vertex_allocator.getUsed();
+  if (free == 0) {
+    return 0.0f;
+  }
+  return 1.0f - static_cast<float>(vertex_allocator.getLargestFreeBlock()) / free;
+}
+
+Buffer GeometryPool::createVertexBuffer(uint32_t capacity) {
+  return Buffer{
+      sizeof(VertexType) * capacity,
+      vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferSrc |
+          vk::BufferUsageFlagBits::eTransferDst,
+      0,
+  };
+}
+
+Buffer GeometryPool::createIndexBuffer(uint32_t capacity) {
+  return Buffer{
+      sizeof(IndexType) * capacity,
+      vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferSrc |
+          vk::BufferUsageFlagBits::eTransferDst,
+      0,
+  };
+}
+}  // namespace TE
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <span>
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/Buffer.hpp"
+#include "ToyEngine/Renderer/FreeListAllocator.hpp"
+#include "ToyEngine/Renderer/Frustum.hpp"
+#include "ToyEngine/Renderer/Vertex.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Location of a mesh inside the pool, arguments of drawIndexed().
+struct MeshRange {
+  uint32_t first_index = 0;
+  uint32_t index_count = 0;
+  int32_t vertex_offset = 0;
+  uint32_t vertex_count = 0;
+};
+
+// Sub-allocates the vertices and indices of many meshes from one vertex and one index buffer, so
+// they can be drawn after a single bind. Ranges may move when the pool grows or is compacted,
+// look them up through the mesh id every frame.
+class GeometryPool {
+ public:
+  using VertexType = Vertex;
+  // 32-bit so meshes may have more than 65536 vertices, all meshes share one index buffer binding
+  using IndexType = uint32_t;
+  static constexpr vk::IndexType INDEX_TYPE = vk::IndexType::eUint32;
+
+  GeometryPool(uint32_t vertex_capacity = INITIAL_VERTEX_CAPACITY,
+               uint32_t index_capacity = INITIAL_INDEX_CAPACITY);
+
+  uint32_t add(std::span<const VertexType> vertices, std::span<const IndexType> indices);
+  // The range is freed once the frames recorded before may no longer draw it.
+  void remove(uint32_t mesh);
+  // Packs all meshes to the start of fresh buffers, the copies are recorded by the next flush().
+  void compact();
+
+  // Copies of the meshes into the buffers replacing the previous ones.
+  struct Relocation {
+    vk::Buffer src_vertex_buffer;
+    vk::Buffer src_index_buffer;
+    vk::Buffer dst_vertex_buffer;
+    vk::Buffer dst_index_buffer;
+    std::vector<vk::BufferCopy> vertex_copies;
+    std::vector<vk::BufferCopy> index_copies;
+  };
+
+  // Returns the relocations since the last flush, to be called once per frame. The replaced
+  // buffers are kept alive until the frames recording the relocations have completed.
+  std::vector<Relocation> flush();
+  // Records relocations outside of a render pass, may run on the render thread while the pool is
+  // being changed.
+  static void record(vk::CommandBuffer cmd, std::span<const Relocation> relocations);
+  inline void bind(vk::CommandBuffer cmd) const {
+    bind(cmd, vertex_buffer.getBuffer(), index_buffer.getBuffer());
+  }
+  static void bind(vk::CommandBuffer cmd, vk::Buffer vertex_buffer, vk::Buffer index_buffer);
+
+  inline const MeshRange& getRange(uint32_t mesh) const { return meshes[mesh]; }
+  // local bounding sphere, xyz center and w radius
+  inline const glm::vec4& getBounds(uint32_t mesh) const { return bounds[mesh]; }
+  inline const Aabb& getBox(uint32_t mesh) const { return boxes[mesh]; }
+  inline vk::Buffer getVertexBuffer() const { return vertex_buffer.getBuffer(); }
+  inline vk::Buffer getIndexBuffer() const { return index_buffer.getBuffer(); }
+  // share of the free space not usable by the largest allocation
+  float getFragmentation() const;
+
+  static constexpr uint32_t INITIAL_VERTEX_CAPACITY = 64 * 1024;
+  static constexpr uint32_t INITIAL_INDEX_CAPACITY = 192 * 1024;
+
+ private:
+  struct Retired {
+    Buffer vertex_buffer;
+    Buffer index_buffer;
+    uint64_t frame;
+  };
+
+  struct Removed {
+    uint32_t mesh;
+    uint64_t frame;
+  };
+
+  void relocate(uint32_t vertex_capacity, uint32_t index_capacity);
+  void release(uint32_t mesh);
+  static Buffer createVertexBuffer(uint32_t capacity);
+  static Buffer createIndexBuffer(uint32_t capacity);
+
+  Buffer vertex_buffer;
+  Buffer index_buffer;
+  FreeListAllocator vertex_allocator;
+  FreeListAllocator index_allocator;
+
+  std::vector<MeshRange> meshes;
+  std::vector<glm::vec4> bounds;
+  std::vector<Aabb> boxes;
+  std::vector<uint32_t> free_meshes;
+
+  std::vector<Relocation> relocations;
+  std::vector<Retired> retired;
+  std::vector<Removed> removed;
+  uint64_t frame = 0;
+};
+}  // namespace TE
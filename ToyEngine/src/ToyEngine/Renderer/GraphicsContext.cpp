@@ -10,7 +10,7 @@
 #include "ToyEngine/Renderer/Device.hpp"
 #include "ToyEngine/Renderer/Shader.hpp"
 #include "ToyEngine/Renderer/SwapChain.hpp"
-#include "ToyEngine/Renderer/VertexArray.hpp"
+#include "ToyEngine/Renderer/Vertex.hpp"
 
 // instantiate the default dispatcher
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
@@ -20,7 +20,32 @@ namespace TE {
 GraphicsContext* GraphicsContext::instance = nullptr;
 
 GraphicsContext::GraphicsContext(GLFWwindow* window)
-    : device{window}, allocator{device}, swapchain{window, device} {
+    : device{window},
+      allocator{device},
+      swapchain{window, device},
+      upload_scheduler{device, allocator},
+      bindless{device, MAX_FRAMES_IN_FLIGHT},
+      frame_allocator{allocator.getAllocator(), bindless, FRAME_ALLOCATOR_SIZE,
+                      MAX_FRAMES_IN_FLIGHT},
+      pipeline_cache{device, PIPELINE_CACHE_PATH},
+      pipelines{device, pipeline_cache.get(), bindless.getDescriptorSetLayout()} {
+  init();
+}
+
+GraphicsContext::GraphicsContext(vk::Extent2D extent)
+    : device{nullptr},
+      allocator{device},
+      swapchain{extent, device, allocator},
+      upload_scheduler{device, allocator},
+      bindless{device, MAX_FRAMES_IN_FLIGHT},
+      frame_allocator{allocator.getAllocator(), bindless, FRAME_ALLOCATOR_SIZE,
+                      MAX_FRAMES_IN_FLIGHT},
+      pipeline_cache{device, PIPELINE_CACHE_PATH},
+      pipelines{device, pipeline_cache.get(), bindless.getDescriptorSetLayout()} {
+  init();
+}
+
+void GraphicsContext::init() {
   assert(instance == nullptr);
   instance = this;
 
@@ -32,7 +57,6 @@ GraphicsContext::GraphicsContext(GLFWwindow* window)
   transient_command_pool = device.getDevice().createCommandPool(pool_info);
 
   createRenderPass();
-  createDescriptorSets();
   createGraphicsPipeline();
   swapchain.createFramebuffers(render_pass);
   createFrameData();
@@ -41,26 +65,20 @@ GraphicsContext::GraphicsContext(GLFWwindow* window)
 GraphicsContext::~GraphicsContext() {
   auto device = this->device.getDevice();
 
+  // release the staging buffers while the context is still accessible
+  upload_scheduler.wait(upload_scheduler.flush());
+  upload_scheduler.collect();
+
   for (auto& frame : frame_data) {
+    if (frame.timestamp_pool) {
+      device.destroyQueryPool(frame.timestamp_pool);
+    }
     device.destroySemaphore(frame.acquire_semaphore);
     device.destroyFence(frame.submit_fence);
     device.destroyCommandPool(frame.command_pool);
-  }
-
-  if (graphics_pipeline) {
-    device.destroyPipeline(graphics_pipeline);
-  }
-
-  if (pipeline_layout) {
-    device.destroyPipelineLayout(pipeline_layout);
-  }
-
-  if (descriptor_pool) {
-    device.destroyDescriptorPool(descriptor_pool);
-  }
-
-  if (descriptor_set_layout) {
-    device.destroyDescriptorSetLayout(descriptor_set_layout);
+    for (auto& recording : frame.recording_pools) {
+      device.destroyCommandPool(recording.pool);
+    }
   }
 
   if (render_pass) {
@@ -79,34 +97,80 @@ void GraphicsContext::beginFrame() {
   auto& frame = frame_data[current_frame];
 
   (void)device.waitForFences(frame.submit_fence, true, UINT64_MAX);
+  readGpuTimings(frame);
   swapchain.acquireNextImage(frame.acquire_semaphore);
   device.resetFences(frame.submit_fence);
   device.resetCommandPool(frame.command_pool);
+  for (auto& recording : frame.recording_pools) {
+    device.resetCommandPool(recording.pool);
+    recording.used = 0;
+  }
 
   vk::CommandBufferBeginInfo begin_info{.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit};
   frame.command_buffer.begin(begin_info);
+  frame_allocator.beginFrame(current_frame);
+
+  if (frame.timestamp_pool) {
+    frame.command_buffer.resetQueryPool(frame.timestamp_pool, 0, MAX_GPU_SCOPES * 2);
+  }
+
+  bindless.flush();
+
+  // hand all uploads issued so far over to this frame
+  upload_scheduler.collect();
+  flushed_upload_value = upload_scheduler.recordAcquires(frame.command_buffer);
+  acquired_upload_value.store(flushed_upload_value, std::memory_order_release);
 }
 
 void GraphicsContext::endFrame() {
   auto queue = this->device.getQueue();
   auto& frame = frame_data[current_frame];
 
+  assert(frame.open_scopes.empty());
   frame.command_buffer.end();
+  frame_allocator.endFrame();
+
+  std::vector<vk::Semaphore> wait_semaphores;
+  std::vector<vk::PipelineStageFlags> wait_stages;
+  std::vector<uint64_t> wait_values;  // ignored for binary semaphores
+  if (!isHeadless()) {
+    wait_semaphores.push_back(frame.acquire_semaphore);
+    wait_stages.push_back(vk::PipelineStageFlagBits::eColorAttachmentOutput);
+    wait_values.push_back(0);
+  }
+  if (flushed_upload_value > waited_upload_value) {
+    // the upload acquire barriers at the start of the frame wait in the transfer stage
+    wait_semaphores.push_back(upload_scheduler.getTimeline());
+    wait_stages.push_back(vk::PipelineStageFlagBits::eTransfer);
+    wait_values.push_back(flushed_upload_value);
+    waited_upload_value = flushed_upload_value;
+  }
 
-  vk::Semaphore wait_semaphores[] = {frame.acquire_semaphore};
-  vk::PipelineStageFlags wait_stages[] = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
-  vk::Semaphore signal_semaphores[] = {swapchain.getSubmitSemaphore()};
+  vk::Semaphore signal_semaphores[] = {
+      isHeadless() ? vk::Semaphore{} : swapchain.getSubmitSemaphore(),
+  };
+  vk::TimelineSemaphoreSubmitInfo timeline_info{
+      .waitSemaphoreValueCount = static_cast<uint32_t>(wait_values.size()),
+      .pWaitSemaphoreValues = wait_values.data(),
+  };
   vk::SubmitInfo submit_info{
-      .waitSemaphoreCount = 1,
-      .pWaitSemaphores = wait_semaphores,
-      .pWaitDstStageMask = wait_stages,
+      .pNext = &timeline_info,
+      .waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size()),
+      .pWaitSemaphores = wait_semaphores.data(),
+      .pWaitDstStageMask = wait_stages.data(),
       .commandBufferCount = 1,
       .pCommandBuffers = &frame.command_buffer,
-      .signalSemaphoreCount = 1,
+      .signalSemaphoreCount = isHeadless() ? 0u : 1u,
       .pSignalSemaphores = signal_semaphores,
   };
+  std::lock_guard lock{device.getQueueMutex()};
   queue.submit(submit_info, frame.submit_fence);
 
+  if (isHeadless()) {
+    current_frame = (current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+    return;
+  }
+
   vk::SwapchainKHR swc = swapchain.get();
   uint32_t image = swapchain.getImage();
 
@@ -119,13 +183,99 @@ void GraphicsContext::endFrame() {
   };
   (void)queue.presentKHR(present_info);
 
-  current_frame = (current_frame + 1) % max_frames_in_flight;
+  current_frame = (current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
-void GraphicsContext::beginPass() {
+void GraphicsContext::beginPass(std::string_view scope, vk::SubpassContents contents) {
   vk::ClearValue clear_value{{{{0.01f, 0.01f, 0.033f, 1.0f}}}};
   auto extent = swapchain.getExtent();
 
+  vk::RenderPassBeginInfo render_pass_info{
+      .renderPass = render_pass,
+      .framebuffer = swapchain.getFramebuffer(),
+      .renderArea = {{0, 0}, extent},
+      .clearValueCount = 1,
+      .pClearValues = &clear_value,
+  };
+
+  beginGpuScope(scope);
+
+  auto& frame = frame_data[current_frame];
+  frame.command_buffer.beginRenderPass(render_pass_info, contents);
+  pass_contents = contents;
+  if (contents == vk::SubpassContents::eInline) {
+    setPassState(frame.command_buffer);
+  }
+}
+
+void GraphicsContext::endPass() {
+  auto& frame = frame_data[current_frame];
+  frame.command_buffer.endRenderPass();
+  pass_contents = vk::SubpassContents::eInline;
+
+  endGpuScope();
+}
+
+void GraphicsContext::recordParallel(
+    JobSystem& jobs, uint32_t count,
+    const std::function<void(vk::CommandBuffer, uint32_t, uint32_t)>& commands) {
+  assert(pass_contents == vk::SubpassContents::eSecondaryCommandBuffers);
+  if (count == 0) {
+    return;
+  }
+
+  auto& frame = frame_data[current_frame];
+  uint32_t job_count = std::min(count, jobs.getThreadCount());
+  while (frame.recording_pools.size() < job_count) {
+    frame.recording_pools.push_back({
+        .pool = device.getDevice().createCommandPool({
+            .flags = vk::CommandPoolCreateFlagBits::eTransient,
+            .queueFamilyIndex = device.getGraphicsQueueIndex(),
+        }),
+    });
+  }
+
+  // every job owns a pool, command pools must not be used by several threads at once
+  std::vector<vk::CommandBuffer> secondaries(job_count);
+  jobs.parallelFor(job_count, 1, [&](uint32_t begin, uint32_t end) {
+    for (uint32_t j = begin; j < end; j++) {
+      vk::CommandBuffer cmd = beginSecondary(frame.recording_pools[j]);
+      commands(cmd, count * j / job_count, count * (j + 1) / job_count);
+      cmd.end();
+      secondaries[j] = cmd;
+    }
+  });
+
+  frame.command_buffer.executeCommands(secondaries);
+}
+
+vk::CommandBuffer GraphicsContext::beginSecondary(RecordingPool& recording) {
+  if (recording.used == recording.buffers.size()) {
+    vk::CommandBufferAllocateInfo alloc_info{
+        .commandPool = recording.pool,
+        .level = vk::CommandBufferLevel::eSecondary,
+        .commandBufferCount = 1,
+    };
+    recording.buffers.push_back(device.getDevice().allocateCommandBuffers(alloc_info)[0]);
+  }
+  vk::CommandBuffer cmd = recording.buffers[recording.used++];
+
+  vk::CommandBufferInheritanceInfo inheritance_info{
+      .renderPass = render_pass,
+      .subpass = 0,
+      .framebuffer = swapchain.getFramebuffer(),
+  };
+  cmd.begin({
+      .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit |
+               vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+      .pInheritanceInfo = &inheritance_info,
+  });
+  setPassState(cmd);
+  return cmd;
+}
+
+void GraphicsContext::setPassState(vk::CommandBuffer cmd) const {
+  auto extent = swapchain.getExtent();
   vk::Viewport viewport{
       .x = 0.0f,
       .y = 0.0f,
@@ -134,27 +284,78 @@ void GraphicsContext::beginPass() {
       .minDepth = 0.0f,
       .maxDepth = 1.0f,
   };
-
   vk::Rect2D scissor{{0, 0}, extent};
 
-  vk::RenderPassBeginInfo render_pass_info{
-      .renderPass = render_pass,
-      .framebuffer = swapchain.getFramebuffer(),
-      .renderArea = {{0, 0}, extent},
-      .clearValueCount = 1,
-      .pClearValues = &clear_value,
-  };
+  cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, graphics_pipeline->pipeline);
+  cmd.setViewport(0, viewport);
+  cmd.setScissor(0, scissor);
+}
 
+void GraphicsContext::beginGpuScope(std::string_view name) {
   auto& frame = frame_data[current_frame];
-  frame.command_buffer.beginRenderPass(render_pass_info, vk::SubpassContents::eInline);
-  frame.command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphics_pipeline);
-  frame.command_buffer.setViewport(0, viewport);
-  frame.command_buffer.setScissor(0, scissor);
+  if (!frame.timestamp_pool || frame.timestamp_count + 2 > MAX_GPU_SCOPES * 2) {
+    // keep the nesting balanced for endGpuScope()
+    frame.open_scopes.push_back(UINT32_MAX);
+    return;
+  }
+
+  uint32_t begin_query = frame.timestamp_count;
+  frame.timestamp_count += 2;
+  frame.command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, frame.timestamp_pool,
+                                      begin_query);
+
+  frame.open_scopes.push_back(frame.gpu_scopes.size());
+  frame.gpu_scopes.push_back({
+      .name = std::string(name),
+      .depth = static_cast<uint32_t>(frame.open_scopes.size() - 1),
+      .begin_query = begin_query,
+      .end_query = begin_query + 1,
+  });
 }
 
-void GraphicsContext::endPass() {
+void GraphicsContext::endGpuScope() {
   auto& frame = frame_data[current_frame];
-  frame.command_buffer.endRenderPass();
+  assert(!frame.open_scopes.empty());
+
+  uint32_t scope = frame.open_scopes.back();
+  frame.open_scopes.pop_back();
+  if (scope == UINT32_MAX) {
+    return;
+  }
+
+  frame.command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe,
+                                      frame.timestamp_pool, frame.gpu_scopes[scope].end_query);
+}
+
+void GraphicsContext::readGpuTimings(FrameData& frame) {
+  if (frame.gpu_scopes.empty()) {
+    return;
+  }
+
+  // the frame's fence has been waited on, so this never blocks
+  std::vector<uint64_t> timestamps(frame.timestamp_count);
+  auto res = device.getDevice().getQueryPoolResults(
+      frame.timestamp_pool, 0, frame.timestamp_count, timestamps.size() * sizeof(uint64_t),
+      timestamps.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+
+  if (res == vk::Result::eSuccess) {
+    double period = device.getProperties().limits.timestampPeriod;
+    std::vector<GpuTiming> timings;
+    for (const auto& scope : frame.gpu_scopes) {
+      uint64_t ticks = timestamps[scope.end_query] - timestamps[scope.begin_query];
+      timings.push_back({
+          .name = scope.name,
+          .depth = scope.depth,
+          .milliseconds = static_cast<double>(ticks) * period / 1e6,
+      });
+    }
+
+    std::lock_guard lock{gpu_timings_mutex};
+    gpu_timings = std::move(timings);
+  }
+
+  frame.gpu_scopes.clear();
+  frame.timestamp_count = 0;
 }
 
 void GraphicsContext::createRenderPass() {
@@ -166,7 +367,7 @@ void GraphicsContext::createRenderPass() {
       .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
       .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
       .initialLayout = vk::ImageLayout::eUndefined,
-      .finalLayout = vk::ImageLayout::ePresentSrcKHR,
+      .finalLayout = swapchain.getFinalLayout(),
   };
 
   vk::AttachmentReference color_attachment_ref{
@@ -201,210 +402,22 @@ void GraphicsContext::createRenderPass() {
   render_pass = device.getDevice().createRenderPass(render_pass_info);
 }
 
-void GraphicsContext::createDescriptorSets() {
-  std::array<vk::DescriptorSetLayoutBinding, 3> layout_bindings = {
-      vk::DescriptorSetLayoutBinding{
-          .binding = 0,
-          .descriptorType = vk::DescriptorType::eUniformBuffer,
-          .descriptorCount = UNIFORM_BUFFER_COUNT,
-          .stageFlags = vk::ShaderStageFlagBits::eAll,
-      },
-      {
-          .binding = 1,
-          .descriptorType = vk::DescriptorType::eStorageBuffer,
-          .descriptorCount = STORAGE_BUFFER_COUNT,
-          .stageFlags = vk::ShaderStageFlagBits::eAll,
-      },
-      {
-          .binding = 2,
-          .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-          .descriptorCount = TEXTURE_COUNT,
-          .stageFlags = vk::ShaderStageFlagBits::eAll,
-      },
-  };
-  std::array<vk::DescriptorBindingFlags, layout_bindings.size()> layout_flags = {
-      vk::DescriptorBindingFlagBits::ePartiallyBound |
-          vk::DescriptorBindingFlagBits::eUpdateAfterBind,
-      vk::DescriptorBindingFlagBits::ePartiallyBound |
-          vk::DescriptorBindingFlagBits::eUpdateAfterBind,
-      vk::DescriptorBindingFlagBits::ePartiallyBound |
-          vk::DescriptorBindingFlagBits::eUpdateAfterBind,
-  };
-  vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags{
-      .bindingCount = layout_flags.size(),
-      .pBindingFlags = layout_flags.data(),
-  };
-  vk::DescriptorSetLayoutCreateInfo layout_info{
-      .pNext = &binding_flags,
-      .flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
-      .bindingCount = layout_bindings.size(),
-      .pBindings = layout_bindings.data(),
-  };
-  descriptor_set_layout = device.getDevice().createDescriptorSetLayout(layout_info);
-
-  std::array<vk::DescriptorPoolSize, layout_bindings.size()> pool_sizes = {
-      vk::DescriptorPoolSize{
-          .type = vk::DescriptorType::eUniformBuffer,
-          .descriptorCount = UNIFORM_BUFFER_COUNT,
-      },
-      {
-          .type = vk::DescriptorType::eStorageBuffer,
-          .descriptorCount = STORAGE_BUFFER_COUNT,
-      },
-      {
-          .type = vk::DescriptorType::eCombinedImageSampler,
-          .descriptorCount = TEXTURE_COUNT,
-      },
-  };
-  vk::DescriptorPoolCreateInfo pool_info{
-      .flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
-      .maxSets = 1,
-      .poolSizeCount = pool_sizes.size(),
-      .pPoolSizes = pool_sizes.data(),
-  };
-  descriptor_pool = device.getDevice().createDescriptorPool(pool_info);
-
-  vk::DescriptorSetAllocateInfo alloc_info{
-      .descriptorPool = descriptor_pool,
-      .descriptorSetCount = 1,
-      .pSetLayouts = &descriptor_set_layout,
-  };
-  descriptor_set = device.getDevice().allocateDescriptorSets(alloc_info)[0];
-}
-
 void GraphicsContext::createGraphicsPipeline() {
-  auto device = this->device.getDevice();
-
-  std::array<vk::DynamicState, 2> dynamic_states{
-      vk::DynamicState::eViewport,
-      vk::DynamicState::eScissor,
-  };
-
-  vk::PipelineDynamicStateCreateInfo dynamic_state{
-      .dynamicStateCount = static_cast<uint32_t>(dynamic_states.size()),
-      .pDynamicStates = dynamic_states.data(),
-  };
-
-  vk::VertexInputBindingDescription binding_desc{
-      .binding = 0,
-      .stride = sizeof(VertexArray::VertexType),
-      .inputRate = vk::VertexInputRate::eVertex,
+  default_pipeline = {
+      .vertex_shader = "triangle.vert",
+      .fragment_shader = "triangle.frag",
+      .vertex_layout = Vertex::getLayout(),
+      .render_pass = render_pass,
+      .color_formats = {swapchain.getFormat()},
   };
 
-  std::array<vk::VertexInputAttributeDescription, 2> attribute_descs = {
-      vk::VertexInputAttributeDescription{
-          .location = 0,
-          .binding = 0,
-          .format = vk::Format::eR32G32Sfloat,
-          .offset = offsetof(VertexArray::VertexType, pos),
-      },
-      {
-          .location = 1,
-          .binding = 0,
-          .format = vk::Format::eR32G32Sfloat,
-          .offset = offsetof(VertexArray::VertexType, uv),
-      },
-  };
-
-  vk::PipelineVertexInputStateCreateInfo vertex_input{
-      .vertexBindingDescriptionCount = 1,
-      .pVertexBindingDescriptions = &binding_desc,
-      .vertexAttributeDescriptionCount = attribute_descs.size(),
-      .pVertexAttributeDescriptions = attribute_descs.data(),
-  };
-
-  vk::PipelineInputAssemblyStateCreateInfo input_assembly{
-      .topology = vk::PrimitiveTopology::eTriangleList,
-      .primitiveRestartEnable = vk::False,
-  };
-
-  vk::PipelineViewportStateCreateInfo viewport{
-      .viewportCount = 1,
-      .scissorCount = 1,
-  };
-
-  vk::PipelineRasterizationStateCreateInfo rasterization{
-      .depthClampEnable = vk::False,
-      .rasterizerDiscardEnable = vk::False,
-      .polygonMode = vk::PolygonMode::eFill,
-      .cullMode = vk::CullModeFlagBits::eBack,
-      .frontFace = vk::FrontFace::eClockwise,
-      .depthBiasEnable = vk::False,
-      .lineWidth = 1.0f,
-  };
-
-  vk::PipelineMultisampleStateCreateInfo multisampling{
-      .rasterizationSamples = vk::SampleCountFlagBits::e1,
-      .sampleShadingEnable = vk::False,
-  };
-
-  vk::PipelineDepthStencilStateCreateInfo depth_stencil;
-
-  vk::PipelineColorBlendAttachmentState blend_attachment{
-      .blendEnable = vk::False,
-      .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
-                        vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA,
-  };
-
-  vk::PipelineColorBlendStateCreateInfo color_blending{
-      .logicOpEnable = vk::False,
-      .attachmentCount = 1,
-      .pAttachments = &blend_attachment,
-  };
-
-  vk::PushConstantRange push_constants{
-      .stageFlags = vk::ShaderStageFlagBits::eVertex,
-      .offset = 0,
-      .size = sizeof(glm::mat4) * sizeof(uint32_t),  // scene.cpp DrawParameters
-  };
-
-  vk::PipelineLayoutCreateInfo pipeline_layout_info{
-      .setLayoutCount = 1,
-      .pSetLayouts = &descriptor_set_layout,
-      .pushConstantRangeCount = 1,
-      .pPushConstantRanges = &push_constants,
-  };
-
-  pipeline_layout = device.createPipelineLayout(pipeline_layout_info);
-
-  std::vector<Shader> shaders{
-      {"triangle.vert", ShaderType::VERTEX},
-      {"triangle.frag", ShaderType::FRAGMENT},
-  };
-  std::vector<vk::PipelineShaderStageCreateInfo> shader_stages;
-  for (auto& shader : shaders) {
-    shader_stages.emplace_back(shader.getStageCreateInfo(device));
-  }
-
-  vk::GraphicsPipelineCreateInfo pipeline_info{
-      .stageCount = 2,
-      .pStages = shader_stages.data(),
-      .pVertexInputState = &vertex_input,
-      .pInputAssemblyState = &input_assembly,
-      .pViewportState = &viewport,
-      .pRasterizationState = &rasterization,
-      .pMultisampleState = &multisampling,
-      .pDepthStencilState = &depth_stencil,
-      .pColorBlendState = &color_blending,
-      .pDynamicState = &dynamic_state,
-      .layout = pipeline_layout,
-      .renderPass = render_pass,
-      .subpass = 0,
-  };
-
-  vk::Result res;  // TODO: check result
-  std::tie(res, graphics_pipeline) = device.createGraphicsPipeline(nullptr, pipeline_info);
-
-  for (auto& stage : shader_stages) {
-    device.destroyShaderModule(stage.module);
-  }
+  graphics_pipeline = &pipelines.get(default_pipeline);
 }
 
 void GraphicsContext::createFrameData() {
   auto device = this->device.getDevice();
 
-  max_frames_in_flight = 2;
-  frame_data.resize(max_frames_in_flight);
+  frame_data.resize(MAX_FRAMES_IN_FLIGHT);
 
   vk::CommandPoolCreateInfo pool_info{
       .queueFamilyIndex = this->device.getGraphicsQueueIndex(),
@@ -415,6 +428,13 @@ void GraphicsContext::createFrameData() {
     frame.submit_fence = device.createFence({.flags = vk::FenceCreateFlagBits::eSignaled});
     frame.acquire_semaphore = device.createSemaphore({});
 
+    if (this->device.getProperties().limits.timestampComputeAndGraphics) {
+      frame.timestamp_pool = device.createQueryPool({
+          .queryType = vk::QueryType::eTimestamp,
+          .queryCount = MAX_GPU_SCOPES * 2,
+      });
+    }
+
     vk::CommandBufferAllocateInfo alloc_info{
         .commandPool = frame.command_pool,
         .level = vk::CommandBufferLevel::ePrimary,
@@ -447,8 +467,14 @@ void GraphicsContext::endTransientExecution(vk::CommandBuffer cmd) const {
       .pCommandBuffers = &cmd,
   };
 
-  device.getQueue().submit(submit_info);
-  device.getQueue().waitIdle();
+  // only wait for this submission instead of draining the whole queue
+  vk::Fence fence = device.getDevice().createFence({});
+  {
+    std::lock_guard lock{device.getQueueMutex()};
+    device.getQueue().submit(submit_info, fence);
+  }
+  (void)device.getDevice().waitForFences(fence, true, UINT64_MAX);
+  device.getDevice().destroyFence(fence);
   device.getDevice().freeCommandBuffers(transient_command_pool, cmd);
 }
 }  // namespace TE
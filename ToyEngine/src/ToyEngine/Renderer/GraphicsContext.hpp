@@ -2,18 +2,33 @@
 
 #include <GLFW/glfw3.h>
 
+#include <atomic>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_handles.hpp>
 
+#include "ToyEngine/Core/JobSystem.hpp"
 #include "ToyEngine/Renderer/Allocator.hpp"
+#include "ToyEngine/Renderer/BindlessRegistry.hpp"
 #include "ToyEngine/Renderer/Device.hpp"
+#include "ToyEngine/Renderer/FrameAllocator.hpp"
+#include "ToyEngine/Renderer/PipelineBuilder.hpp"
+#include "ToyEngine/Renderer/PipelineCache.hpp"
 #include "ToyEngine/Renderer/SwapChain.hpp"
+#include "ToyEngine/Renderer/UploadScheduler.hpp"
 
 namespace TE {
+struct GpuTiming {
+  std::string name;
+  uint32_t depth;  // nesting level of the scope
+  double milliseconds;
+};
+
 class GraphicsContext {
  public:
   GraphicsContext(GLFWwindow* window);
+  // Headless context rendering into offscreen images of the given extent.
+  GraphicsContext(vk::Extent2D extent);
   ~GraphicsContext();
 
   inline static GraphicsContext& get() { return *instance; }
@@ -26,62 +41,143 @@ class GraphicsContext {
   inline vk::CommandPool getCommandPool() const { return transient_command_pool; }
   inline vk::Queue getQueue() const { return device.getQueue(); }
   inline uint32_t getGraphicsQueueIndex() const { return device.getGraphicsQueueIndex(); }
-  inline vk::DescriptorSet getDescriptorSet() const { return descriptor_set; }
-  inline vk::PipelineLayout getPipelineLayout() const { return pipeline_layout; }
+  inline vk::DescriptorSet getDescriptorSet() const { return bindless.getDescriptorSet(); }
+  inline BindlessRegistry& getBindlessRegistry() { return bindless; }
+  inline vk::PipelineCache getPipelineCache() const { return pipeline_cache.get(); }
+  inline vk::PipelineLayout getPipelineLayout() const { return graphics_pipeline->layout; }
+  inline PipelineBuilder& getPipelineBuilder() { return pipelines; }
+  // Description of the pipeline bound by beginPass(), a starting point for variants.
+  inline const GraphicsPipelineDesc& getDefaultPipelineDesc() const { return default_pipeline; }
+  inline const GraphicsPipeline& getDefaultPipeline() const { return *graphics_pipeline; }
+  inline vk::RenderPass getRenderPass() const { return render_pass; }
   inline const SwapChain& getSwapChain() const { return swapchain; }
+  inline bool isHeadless() const { return swapchain.isHeadless(); }
+  // Main thread only, once per frame after polling the window's events.
+  inline void updateFramebufferSize() { swapchain.updateFramebufferSize(); }
+  inline bool supportsDrawIndirectCount() const { return device.supportsDrawIndirectCount(); }
+  inline UploadScheduler& getUploadScheduler() { return upload_scheduler; }
+  // Uploads up to this timeline value have been handed over to a frame that has begun recording,
+  // so their resources may be referenced by descriptors written from now on.
+  inline uint64_t getAcquiredUploadValue() const {
+    return acquired_upload_value.load(std::memory_order_acquire);
+  }
+  inline FrameAllocator& getFrameAllocator() { return frame_allocator; }
+  inline uint32_t getFrameIndex() const { return current_frame; }
   inline vk::CommandBuffer getCommandBuffer() const {
     return frame_data[current_frame].command_buffer;
   }
 
   void beginFrame();
   void endFrame();
-  void beginPass();
+  // With secondary contents the pass only accepts recordParallel() until endPass().
+  void beginPass(std::string_view scope = "Pass",
+                 vk::SubpassContents contents = vk::SubpassContents::eInline);
   void endPass();
 
+  // Records [0, count) into secondary command buffers of the current pass on the job system's
+  // threads, commands(cmd, begin, end) receives a contiguous range. The buffers are executed in
+  // range order so the result doesn't depend on the scheduling. Each buffer starts with the
+  // default pipeline, viewport and scissor set like beginPass().
+  void recordParallel(JobSystem& jobs, uint32_t count,
+                      const std::function<void(vk::CommandBuffer, uint32_t, uint32_t)>& commands);
+
+  // Named GPU timestamp scopes, results are read back once the frame's fence has been signaled.
+  void beginGpuScope(std::string_view name);
+  void endGpuScope();
+  // A copy, the render thread replaces the timings while the simulation may read them.
+  inline std::vector<GpuTiming> getGpuTimings() const {
+    std::lock_guard lock{gpu_timings_mutex};
+    return gpu_timings;
+  }
+
   inline void record(const std::invocable<vk::CommandBuffer> auto&& commands) const {
     commands(frame_data[current_frame].command_buffer);
   }
 
+  inline void record(std::string_view scope,
+                     const std::invocable<vk::CommandBuffer> auto&& commands) {
+    beginGpuScope(scope);
+    commands(frame_data[current_frame].command_buffer);
+    endGpuScope();
+  }
+
+  // Blocks until the commands have executed, prefer the UploadScheduler for uploads.
   inline void executeTransient(const std::invocable<vk::CommandBuffer> auto&& commands) const {
     vk::CommandBuffer command_buffer = beginTransientExecution();
     commands(command_buffer);
     endTransientExecution(command_buffer);
   }
 
+  static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+  // Frames that may still use a resource the simulation retires, one more than in flight as the
+  // render thread may still be recording the previous frame.
+  static constexpr uint32_t MAX_FRAMES_QUEUED = MAX_FRAMES_IN_FLIGHT + 1;
+
  private:
+  void init();
   void createRenderPass();
-  void createDescriptorSets();
   void createGraphicsPipeline();
   void createFrameData();
 
   vk::CommandBuffer beginTransientExecution() const;
   void endTransientExecution(vk::CommandBuffer cmd) const;
 
+  struct GpuScope {
+    std::string name;
+    uint32_t depth;
+    uint32_t begin_query;
+    uint32_t end_query;
+  };
+
+  // Command pool of one recording job, its secondary buffers are reused every frame.
+  struct RecordingPool {
+    vk::CommandPool pool;
+    std::vector<vk::CommandBuffer> buffers;
+    uint32_t used = 0;
+  };
+
   struct FrameData {
     vk::CommandPool command_pool;
+    std::vector<RecordingPool> recording_pools;
     vk::CommandBuffer command_buffer;
     vk::Fence submit_fence;
     vk::Semaphore acquire_semaphore;
+    vk::QueryPool timestamp_pool;
+    uint32_t timestamp_count = 0;
+    std::vector<GpuScope> gpu_scopes;
+    std::vector<uint32_t> open_scopes;
   };
 
+  void readGpuTimings(FrameData& frame);
+  vk::CommandBuffer beginSecondary(RecordingPool& recording);
+  // default pipeline, viewport and scissor of the pass
+  void setPassState(vk::CommandBuffer cmd) const;
+
   Device device;
   Allocator allocator;
   SwapChain swapchain;
+  UploadScheduler upload_scheduler;
+  BindlessRegistry bindless;
+  FrameAllocator frame_allocator;
+  PipelineCache pipeline_cache;
+  PipelineBuilder pipelines;
   vk::CommandPool transient_command_pool;
   vk::RenderPass render_pass;
-  vk::DescriptorSetLayout descriptor_set_layout;
-  vk::DescriptorPool descriptor_pool;
-  vk::DescriptorSet descriptor_set;
-  vk::PipelineLayout pipeline_layout;
-  vk::Pipeline graphics_pipeline;
+  GraphicsPipelineDesc default_pipeline;
+  const GraphicsPipeline* graphics_pipeline = nullptr;
 
   std::vector<FrameData> frame_data;
-  uint32_t max_frames_in_flight;
   uint32_t current_frame = 0;
+  vk::SubpassContents pass_contents = vk::SubpassContents::eInline;
+  std::vector<GpuTiming> gpu_timings;
+  mutable std::mutex gpu_timings_mutex;
+  uint64_t flushed_upload_value = 0;
+  uint64_t waited_upload_value = 0;
+  std::atomic<uint64_t> acquired_upload_value = 0;
 
   static GraphicsContext* instance;
-  static constexpr uint32_t UNIFORM_BUFFER_COUNT = 1000;
-  static constexpr uint32_t STORAGE_BUFFER_COUNT = 1000;
-  static constexpr uint32_t TEXTURE_COUNT = 1000;
+  static constexpr uint32_t MAX_GPU_SCOPES = 64;
+  static constexpr vk::DeviceSize FRAME_ALLOCATOR_SIZE = 8 * 1024 * 1024;
+  static constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
 };
 }  // namespace TE
\ No newline at end of file
@@ -1,14 +1,23 @@
 #pragma once
 
+#include <array>
+#include <bit>
+#include <functional>
 #include <vulkan/vulkan.hpp>
 
 namespace TE {
-inline vk::ImageView createImageView(vk::Device device, vk::Image image, vk::Format format) {
+template <typename T>
+inline void hashCombine(size_t& seed, const T& value) {
+  seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+inline vk::ImageView createImageView(vk::Device device, vk::Image image, vk::Format format,
+                                     uint32_t mip_levels = 1) {
   vk::ImageViewCreateInfo view_info{
       .image = image,
       .viewType = vk::ImageViewType::e2D,
       .format = format,
-      .subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1},
+      .subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, mip_levels, 0, 1},
   };
 
   vk::ImageView image_view;
@@ -20,4 +29,93 @@ inline vk::ImageView createImageView(vk::Device device, vk::Image image, vk::For
   return image_view;
 }
 
+// Number of levels of a full mip chain down to 1x1.
+inline uint32_t getMipLevelCount(uint32_t width, uint32_t height) {
+  return std::bit_width(std::max(width, height));
+}
+
+// Accesses and stages of an image in the layouts used for uploads and sampling.
+inline std::pair<vk::AccessFlags, vk::PipelineStageFlags> getLayoutAccess(vk::ImageLayout layout) {
+  switch (layout) {
+    case vk::ImageLayout::eUndefined:
+      return {vk::AccessFlagBits::eNone, vk::PipelineStageFlagBits::eTopOfPipe};
+    case vk::ImageLayout::eTransferSrcOptimal:
+      return {vk::AccessFlagBits::eTransferRead, vk::PipelineStageFlagBits::eTransfer};
+    case vk::ImageLayout::eTransferDstOptimal:
+      return {vk::AccessFlagBits::eTransferWrite, vk::PipelineStageFlagBits::eTransfer};
+    case vk::ImageLayout::eShaderReadOnlyOptimal:
+      return {vk::AccessFlagBits::eShaderRead, vk::PipelineStageFlagBits::eFragmentShader};
+    default:
+      throw std::runtime_error("Unsupported layout transition!");
+  }
+}
+
+inline void transitionImageLayout(vk::CommandBuffer cmd, vk::Image image,
+                                  vk::ImageLayout old_layout, vk::ImageLayout new_layout,
+                                  const vk::ImageSubresourceRange& range = {
+                                      vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1}) {
+  auto [src_access, src_stage] = getLayoutAccess(old_layout);
+  auto [dst_access, dst_stage] = getLayoutAccess(new_layout);
+  vk::ImageMemoryBarrier barrier{
+      .srcAccessMask = src_access,
+      .dstAccessMask = dst_access,
+      .oldLayout = old_layout,
+      .newLayout = new_layout,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image,
+      .subresourceRange = range,
+  };
+
+  cmd.pipelineBarrier(src_stage, dst_stage, {}, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+// Transitions the color mip levels [base_level, base_level + level_count).
+inline void transitionImageLayout(vk::CommandBuffer cmd, vk::Image image,
+                                  vk::ImageLayout old_layout, vk::ImageLayout new_layout,
+                                  uint32_t base_level, uint32_t level_count) {
+  transitionImageLayout(cmd, image, old_layout, new_layout,
+                        {vk::ImageAspectFlagBits::eColor, base_level, level_count, 0, 1});
+}
+
+// Fills the mip levels after the first one by repeatedly blitting the previous level with a linear
+// filter, the format has to support linear blits. Expects all levels in eShaderReadOnlyOptimal
+// and leaves them there.
+inline void generateMipmaps(vk::CommandBuffer cmd, vk::Image image, vk::Extent2D extent,
+                            uint32_t levels) {
+  if (levels < 2) {
+    return;
+  }
+
+  // the contents of the levels being generated are discarded
+  transitionImageLayout(cmd, image, vk::ImageLayout::eShaderReadOnlyOptimal,
+                        vk::ImageLayout::eTransferSrcOptimal, 0, 1);
+  transitionImageLayout(cmd, image, vk::ImageLayout::eShaderReadOnlyOptimal,
+                        vk::ImageLayout::eTransferDstOptimal, 1, levels - 1);
+
+  int32_t width = extent.width;
+  int32_t height = extent.height;
+  for (uint32_t level = 1; level < levels; level++) {
+    int32_t next_width = std::max(width / 2, 1);
+    int32_t next_height = std::max(height / 2, 1);
+    vk::ImageBlit blit{
+        .srcSubresource = {vk::ImageAspectFlagBits::eColor, level - 1, 0, 1},
+        .srcOffsets = std::array{vk::Offset3D{0, 0, 0}, vk::Offset3D{width, height, 1}},
+        .dstSubresource = {vk::ImageAspectFlagBits::eColor, level, 0, 1},
+        .dstOffsets = std::array{vk::Offset3D{0, 0, 0}, vk::Offset3D{next_width, next_height, 1}},
+    };
+    cmd.blitImage(image, vk::ImageLayout::eTransferSrcOptimal, image,
+                  vk::ImageLayout::eTransferDstOptimal, blit, vk::Filter::eLinear);
+
+    transitionImageLayout(cmd, image, vk::ImageLayout::eTransferSrcOptimal,
+                          vk::ImageLayout::eShaderReadOnlyOptimal, level - 1, 1);
+    transitionImageLayout(cmd, image, vk::ImageLayout::eTransferDstOptimal,
+                          level + 1 < levels ? vk::ImageLayout::eTransferSrcOptimal
+                                             : vk::ImageLayout::eShaderReadOnlyOptimal,
+                          level, 1);
+    width = next_width;
+    height = next_height;
+  }
+}
+
 }  // namespace TE
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "InstanceBuffer.hpp"
+
+#include <cstring>
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/GraphicsContext.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+namespace {
+constexpr uint32_t MIN_BATCH_CAPACITY = 64;
+}  // namespace
+
+InstanceBuffer::InstanceBuffer(uint32_t capacity)
+    : buffer{createBuffer(capacity)}, allocator{capacity * ROWS} {
+  handle = GraphicsContext::get().getBindlessRegistry().registerStorageBuffer({
+      .buffer = buffer.getBuffer(),
+      .offset = 0,
+      .range = VK_WHOLE_SIZE,
+  });
+}
+
+InstanceBuffer::~InstanceBuffer() { GraphicsContext::get().getBindlessRegistry().release(handle); }
+
+uint32_t InstanceBuffer::addBatch() {
+  batches.emplace_back();
+  return batches.size() - 1;
+}
+
+uint32_t InstanceBuffer::add(uint32_t batch, const glm::mat4& transform) {
+  auto& instances = batches[batch];
+  if (instances.count == instances.capacity) {
+    grow(instances);
+  }
+
+  uint32_t instance = instances.count++;
+  set(batch, instance, transform);
+  return instance;
+}
+
+void InstanceBuffer::set(uint32_t batch, uint32_t instance, const glm::mat4& transform) {
+  auto& instances = batches[batch];
+  assert(instance < instances.count);
+
+  // glm is column major, the last row of an affine transform is implicit
+  for (uint32_t row = 0; row < ROWS; row++) {
+    instances.rows[row * instances.capacity + instance] =
+        glm::vec4(transform[0][row], transform[1][row], transform[2][row], transform[3][row]);
+  }
+  markDirty(instances, instance, instance + 1);
+}
+
+void InstanceBuffer::grow(Batch& batch) {
+  uint32_t capacity = std::max(batch.capacity * 2, MIN_BATCH_CAPACITY);
+
+  auto offset = allocator.allocate(ROWS * capacity);
+  if (!offset) {
+    uint32_t buffer_capacity = allocator.getCapacity() / ROWS;
+    relocate(std::max(buffer_capacity * 2, allocator.getUsed() / ROWS + capacity));
+    offset = allocator.allocate(ROWS * capacity);
+    assert(offset);
+  }
+  if (batch.capacity > 0) {
+    allocator.free(batch.offset, ROWS * batch.capacity);
+  }
+
+  std::vector<glm::vec4> rows(ROWS * capacity);
+  for (uint32_t row = 0; row < ROWS; row++) {
+    auto first = batch.rows.begin() + row * batch.capacity;
+    std::copy(first, first + batch.count, rows.begin() + row * capacity);
+  }
+
+  batch.rows = std::move(rows);
+  batch.offset = *offset;
+  batch.capacity = capacity;
+  markDirty(batch, 0, batch.count);
+}
+
+void InstanceBuffer::relocate(uint32_t capacity) {
+  auto& bindless = GraphicsContext::get().getBindlessRegistry();
+
+  // the frames recorded before may still read the old buffer, all batches are uploaded again
+  retired.push_back({
+      .buffer = std::exchange(buffer, createBuffer(capacity)),
+      .frame = frame,
+  });
+  bindless.release(handle);
+  handle = bindless.registerStorageBuffer({
+      .buffer = buffer.getBuffer(),
+      .offset = 0,
+      .range = VK_WHOLE_SIZE,
+  });
+  // the slot is new, so it can be written even if a frame is being recorded
+  bindless.writeDescriptors();
+
+  allocator = FreeListAllocator{capacity * ROWS};
+  for (auto& batch : batches) {
+    if (batch.capacity == 0) {
+      continue;
+    }
+    batch.offset = *allocator.allocate(ROWS * batch.capacity);
+    markDirty(batch, 0, batch.count);
+  }
+}
+
+void InstanceBuffer::markDirty(Batch& batch, uint32_t begin, uint32_t end) {
+  batch.dirty_begin = std::min(batch.dirty_begin, begin);
+  batch.dirty_end = std::max(batch.dirty_end, end);
+}
+
+void InstanceBuffer::flush(Upload& upload) {
+  frame++;
+  std::erase_if(retired, [&](const Retired& old) {
+    return old.frame + GraphicsContext::MAX_FRAMES_QUEUED < frame;
+  });
+
+  upload.buffer = buffer.getBuffer();
+  upload.rows.clear();
+  upload.copies.clear();
+  for (auto& batch : batches) {
+    if (batch.dirty_begin >= batch.dirty_end) {
+      continue;
+    }
+
+    // one copy per row array, packed contiguously
+    uint32_t count = batch.dirty_end - batch.dirty_begin;
+    uint32_t first = batch.offset + batch.dirty_begin;
+    for (uint32_t row = 0; row < ROWS; row++) {
+      auto begin = batch.rows.begin() + row * batch.capacity + batch.dirty_begin;
+      upload.copies.push_back({
+          .srcOffset = sizeof(glm::vec4) * upload.rows.size(),
+          .dstOffset = sizeof(glm::vec4) * (first + row * batch.capacity),
+          .size = sizeof(glm::vec4) * count,
+      });
+      upload.rows.insert(upload.rows.end(), begin, begin + count);
+    }
+
+    batch.dirty_begin = UINT32_MAX;
+    batch.dirty_end = 0;
+  }
+}
+
+void InstanceBuffer::record(vk::CommandBuffer cmd, const Upload& upload) {
+  if (upload.copies.empty()) {
+    return;
+  }
+
+  auto& frame_allocator = GraphicsContext::get().getFrameAllocator();
+  auto staging = frame_allocator.allocate<glm::vec4>(upload.rows.size());
+  std::memcpy(staging.data, upload.rows.data(), sizeof(glm::vec4) * upload.rows.size());
+
+  std::vector<vk::BufferCopy> copies = upload.copies;
+  for (auto& copy : copies) {
+    copy.srcOffset += frame_allocator.getFrameOffset() + staging.offset;
+  }
+
+  // the previous frames' draws may still read the ranges being overwritten
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eVertexShader,
+                      vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, nullptr);
+  cmd.copyBuffer(frame_allocator.getBuffer(), upload.buffer, copies);
+
+  vk::MemoryBarrier barrier{
+      .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+      .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+  };
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                      vk::PipelineStageFlagBits::eVertexShader, {}, barrier, nullptr, nullptr);
+}
+
+Buffer InstanceBuffer::createBuffer(uint32_t capacity) {
+  return Buffer{
+      sizeof(glm::vec4) * ROWS * capacity,
+      vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+      0,
+  };
+}
+}  // namespace TE
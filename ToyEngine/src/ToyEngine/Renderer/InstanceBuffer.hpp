@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/BindlessRegistry.hpp"
+#include "ToyEngine/Renderer/Buffer.hpp"
+#include "ToyEngine/Renderer/FreeListAllocator.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Per-instance transforms of instanced meshes in one device local storage buffer. Each batch owns
+// a range of the buffer holding its transforms as structure-of-arrays: the three rows of the
+// affine matrices in consecutive arrays of the batch's capacity. Only the instances changed since
+// the last flush() are uploaded.
+class InstanceBuffer {
+ public:
+  InstanceBuffer(uint32_t capacity = INITIAL_CAPACITY);
+  ~InstanceBuffer();
+
+  uint32_t addBatch();
+  // Returns the instance index within the batch.
+  uint32_t add(uint32_t batch, const glm::mat4& transform);
+  void set(uint32_t batch, uint32_t instance, const glm::mat4& transform);
+
+  // Rows of the changed instances with their destinations, recorded by record().
+  struct Upload {
+    vk::Buffer buffer;
+    std::vector<glm::vec4> rows;
+    std::vector<vk::BufferCopy> copies;  // srcOffset is relative to rows
+  };
+
+  // Collects the instances changed since the last flush, to be called once per frame. The upload
+  // reuses the vectors' memory.
+  void flush(Upload& upload);
+  // Records the upload through frame memory outside of a render pass, may run on the render
+  // thread while the buffer is being changed.
+  static void record(vk::CommandBuffer cmd, const Upload& upload);
+
+  inline uint32_t getCount(uint32_t batch) const { return batches[batch].count; }
+  // index of the batch's first row in the buffer, in vec4s
+  inline uint32_t getOffset(uint32_t batch) const { return batches[batch].offset; }
+  // distance between the batch's row arrays, in vec4s
+  inline uint32_t getStride(uint32_t batch) const { return batches[batch].capacity; }
+  inline StorageBufferHandle getDescriptor() const { return handle; }
+
+  static constexpr uint32_t INITIAL_CAPACITY = 16 * 1024;  // instances
+  static constexpr uint32_t ROWS = 3;
+
+ private:
+  struct Batch {
+    uint32_t offset = 0;
+    uint32_t capacity = 0;
+    uint32_t count = 0;
+    std::vector<glm::vec4> rows;  // CPU copy in the buffer's layout
+    // changed instances [dirty_begin, dirty_end)
+    uint32_t dirty_begin = UINT32_MAX;
+    uint32_t dirty_end = 0;
+  };
+
+  struct Retired {
+    Buffer buffer;
+    uint64_t frame;
+  };
+
+  void grow(Batch& batch);
+  void relocate(uint32_t capacity);
+  void markDirty(Batch& batch, uint32_t begin, uint32_t end);
+  static Buffer createBuffer(uint32_t capacity);
+
+  Buffer buffer;
+  StorageBufferHandle handle;
+  FreeListAllocator allocator;  // in vec4s
+  std::vector<Batch> batches;
+
+  std::vector<Retired> retired;
+  uint64_t frame = 0;
+};
+}  // namespace TE
@@ -0,0 +1,186 @@
+#include "Mesh.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+#include "ToyEngine/Core/Vfs.hpp"
+#include "ToyEngine/Renderer/MeshOptimizer.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+namespace {
+constexpr uint32_t MESH_MAGIC = 0x534D4554;  // "TEMS"
+constexpr uint32_t MESH_VERSION = 1;
+
+struct MeshHeader {
+  uint32_t magic;
+  uint32_t version;
+  // the vertex layout depends on the glm configuration
+  uint32_t vertex_size;
+  uint32_t vertex_count;
+  uint32_t index_size;
+  uint32_t index_count;
+};
+
+// 1-based, negative values count back from the last element read so far
+uint32_t resolveObjIndex(int64_t index, size_t count, const std::string& path) {
+  int64_t resolved = index < 0 ? static_cast<int64_t>(count) + index : index - 1;
+  if (index == 0 || resolved < 0 || resolved >= static_cast<int64_t>(count)) {
+    throw std::runtime_error("Invalid index in " + path);
+  }
+  return resolved;
+}
+}  // namespace
+
+MeshData MeshData::load(const std::string& path) {
+  auto file = Vfs::get().open(path);
+  auto bytes = file.getBytes();
+
+  MeshHeader header;
+  if (bytes.size() < sizeof(header)) {
+    throw std::runtime_error("Invalid mesh " + path);
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != MESH_MAGIC || header.version != MESH_VERSION ||
+      header.vertex_size != sizeof(Vertex) ||
+      (header.index_size != 2 && header.index_size != 4)) {
+    throw std::runtime_error("Invalid or outdated mesh " + path);
+  }
+
+  MeshData mesh;
+  mesh.index_type = header.index_size == 2 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+  mesh.vertices.resize(header.vertex_count);
+  mesh.indices.resize(size_t{header.index_count} * header.index_size);
+  size_t vertices_size = mesh.vertices.size() * sizeof(Vertex);
+  if (bytes.size() != sizeof(header) + vertices_size + mesh.indices.size()) {
+    throw std::runtime_error("Truncated mesh " + path);
+  }
+  std::memcpy(mesh.vertices.data(), bytes.data() + sizeof(header), vertices_size);
+  std::memcpy(mesh.indices.data(), bytes.data() + sizeof(header) + vertices_size,
+              mesh.indices.size());
+  return mesh;
+}
+
+void MeshData::save(const std::string& path) const {
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to write mesh " + path);
+  }
+
+  MeshHeader header{
+      .magic = MESH_MAGIC,
+      .version = MESH_VERSION,
+      .vertex_size = sizeof(Vertex),
+      .vertex_count = static_cast<uint32_t>(vertices.size()),
+      .index_size = getIndexSize(),
+      .index_count = getIndexCount(),
+  };
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(Vertex));
+  file.write(reinterpret_cast<const char*>(indices.data()), indices.size());
+}
+
+MeshData MeshData::importObj(const std::string& path) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to open mesh " + path);
+  }
+
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec2> uvs;
+  MeshData mesh;
+  std::vector<uint32_t> indices;
+  // vertex of every position and uv pair
+  std::unordered_map<uint64_t, uint32_t> vertex_indices;
+
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream stream{line};
+    std::string type;
+    stream >> type;
+
+    if (type == "v") {
+      glm::vec3 position;
+      stream >> position.x >> position.y >> position.z;
+      positions.push_back(position);
+    } else if (type == "vt") {
+      glm::vec2 uv;
+      stream >> uv.x >> uv.y;
+      // OBJ has its origin at the bottom left, images at the top left
+      uvs.push_back({uv.x, 1.0f - uv.y});
+    } else if (type == "f") {
+      std::vector<uint32_t> corners;
+      std::string corner;
+      while (stream >> corner) {
+        // v, v/vt, v//vn or v/vt/vn, normals are ignored
+        int64_t position_index = std::stoll(corner);
+        int64_t uv_index = 0;
+        size_t slash = corner.find('/');
+        if (slash != std::string::npos && slash + 1 < corner.size() && corner[slash + 1] != '/') {
+          uv_index = std::stoll(corner.substr(slash + 1));
+        }
+
+        uint32_t position = resolveObjIndex(position_index, positions.size(), path);
+        uint32_t uv = uv_index ? resolveObjIndex(uv_index, uvs.size(), path) : UINT32_MAX;
+        uint64_t key = uint64_t{position} << 32 | uv;
+        auto [vertex, inserted] = vertex_indices.try_emplace(key, mesh.vertices.size());
+        if (inserted) {
+          mesh.vertices.push_back({
+              .pos = positions[position],
+              .uv = uv == UINT32_MAX ? glm::vec2{0.0f} : uvs[uv],
+          });
+        }
+        corners.push_back(vertex->second);
+      }
+
+      if (corners.size() < 3) {
+        throw std::runtime_error("Face with less than three corners in " + path);
+      }
+      for (size_t i = 2; i < corners.size(); i++) {
+        indices.insert(indices.end(), {corners[0], corners[i - 1], corners[i]});
+      }
+    }
+  }
+
+  mesh.setIndices(indices);
+  return mesh;
+}
+
+void MeshData::optimize() {
+  auto optimized = getIndices32();
+  optimizeVertexCache(optimized, vertices.size());
+  auto remap = optimizeVertexFetch(optimized, vertices.size());
+
+  std::vector<Vertex> reordered(vertices.size() - std::ranges::count(remap, UINT32_MAX));
+  for (uint32_t v = 0; v < vertices.size(); v++) {
+    if (remap[v] != UINT32_MAX) {
+      reordered[remap[v]] = vertices[v];
+    }
+  }
+  vertices = std::move(reordered);
+  setIndices(optimized);
+}
+
+void MeshData::setIndices(std::span<const uint32_t> indices) {
+  if (vertices.size() <= UINT16_MAX + 1) {
+    index_type = vk::IndexType::eUint16;
+    std::vector<uint16_t> narrow(indices.begin(), indices.end());
+    this->indices.resize(narrow.size() * sizeof(uint16_t));
+    std::memcpy(this->indices.data(), narrow.data(), this->indices.size());
+  } else {
+    index_type = vk::IndexType::eUint32;
+    this->indices.resize(indices.size() * sizeof(uint32_t));
+    std::memcpy(this->indices.data(), indices.data(), this->indices.size());
+  }
+}
+
+std::vector<uint32_t> MeshData::getIndices32() const {
+  if (index_type == vk::IndexType::eUint16) {
+    auto narrow = getIndices<uint16_t>();
+    return {narrow.begin(), narrow.end()};
+  }
+  auto wide = getIndices<uint32_t>();
+  return {wide.begin(), wide.end()};
+}
+}  // namespace TE
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <span>
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/Vertex.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Vertices and indices of a mesh in the layout the GPU reads them. The indices are 16-bit whenever
+// the vertices fit, 32-bit otherwise.
+struct MeshData {
+  std::vector<Vertex> vertices;
+  vk::IndexType index_type = vk::IndexType::eUint16;
+  std::vector<uint8_t> indices;
+
+  // Reads a mesh written by save() through the Vfs, its vertices and indices are copied as they
+  // are.
+  static MeshData load(const std::string& path);
+  void save(const std::string& path) const;
+  // Imports the triangles of an OBJ file, polygons are fanned and shared corners become a single
+  // vertex.
+  static MeshData importObj(const std::string& path);
+
+  // Reorders the triangles for the post-transform vertex cache and then the vertices in the
+  // order the triangles use them, unused vertices are dropped.
+  void optimize();
+
+  // Stores the indices with the narrowest type that fits the vertices.
+  void setIndices(std::span<const uint32_t> indices);
+  // widened to 32 bits
+  std::vector<uint32_t> getIndices32() const;
+  template <typename T>
+  inline std::span<const T> getIndices() const {
+    assert(sizeof(T) == getIndexSize());
+    return {reinterpret_cast<const T*>(indices.data()), getIndexCount()};
+  }
+
+  inline uint32_t getIndexSize() const { return index_type == vk::IndexType::eUint16 ? 2 : 4; }
+  inline uint32_t getIndexCount() const { return indices.size() / getIndexSize(); }
+};
+}  // namespace TE
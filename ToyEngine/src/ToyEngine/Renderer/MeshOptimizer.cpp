@@ -0,0 +1,175 @@
+#include "MeshOptimizer.hpp"
+
+#include <cmath>
+
+#include "tepch.hpp"
+
+namespace TE {
+namespace {
+// size of the modeled LRU cache, larger than the hardware's so that triangles are picked ahead
+constexpr uint32_t CACHE_SIZE = 32;
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+constexpr uint32_t NOT_CACHED = UINT32_MAX;
+
+float scoreVertex(uint32_t cache_position, uint32_t remaining_triangles) {
+  if (remaining_triangles == 0) {
+    return -1.0f;  // never picked again
+  }
+
+  float score = 0.0f;
+  if (cache_position < 3) {
+    // the vertices of the last triangle get a fixed score, so the strip direction is free
+    score = LAST_TRIANGLE_SCORE;
+  } else if (cache_position != NOT_CACHED) {
+    float scale = 1.0f / (CACHE_SIZE - 3);
+    score = std::pow(1.0f - (cache_position - 3) * scale, CACHE_DECAY_POWER);
+  }
+  // finish off vertices with few triangles left, they would otherwise be transformed again later
+  return score + VALENCE_BOOST_SCALE * std::pow(remaining_triangles, -VALENCE_BOOST_POWER);
+}
+}  // namespace
+
+float computeAcmr(std::span<const uint32_t> indices, uint32_t vertex_count, uint32_t cache_size) {
+  if (indices.size() < 3) {
+    return 0.0f;
+  }
+
+  // frame of the transform that put each vertex into the cache
+  std::vector<uint64_t> cached_at(vertex_count, 0);
+  uint64_t transforms = 0;
+  for (uint32_t index : indices) {
+    // in the cache if fewer than cache_size other vertices were transformed since
+    if (cached_at[index] == 0 || transforms - cached_at[index] >= cache_size) {
+      cached_at[index] = ++transforms;
+    }
+  }
+  return static_cast<float>(transforms) / (indices.size() / 3);
+}
+
+void optimizeVertexCache(std::span<uint32_t> indices, uint32_t vertex_count) {
+  uint32_t triangle_count = indices.size() / 3;
+  if (triangle_count == 0) {
+    return;
+  }
+
+  // triangles of every vertex, the not yet emitted ones come first
+  std::vector<uint32_t> remaining(vertex_count, 0);
+  for (uint32_t index : indices) {
+    remaining[index]++;
+  }
+  std::vector<uint32_t> first_triangle(vertex_count + 1, 0);
+  for (uint32_t v = 0; v < vertex_count; v++) {
+    first_triangle[v + 1] = first_triangle[v] + remaining[v];
+  }
+  std::vector<uint32_t> vertex_triangles(indices.size());
+  std::vector<uint32_t> filled(first_triangle.begin(), first_triangle.end() - 1);
+  for (uint32_t i = 0; i < indices.size(); i++) {
+    vertex_triangles[filled[indices[i]]++] = i / 3;
+  }
+
+  std::vector<uint32_t> cache_position(vertex_count, NOT_CACHED);
+  std::vector<float> vertex_scores(vertex_count);
+  for (uint32_t v = 0; v < vertex_count; v++) {
+    vertex_scores[v] = scoreVertex(NOT_CACHED, remaining[v]);
+  }
+  std::vector<float> triangle_scores(triangle_count);
+  for (uint32_t t = 0; t < triangle_count; t++) {
+    for (uint32_t corner = 0; corner < 3; corner++) {
+      triangle_scores[t] += vertex_scores[indices[t * 3 + corner]];
+    }
+  }
+
+  std::vector<uint8_t> emitted(triangle_count, 0);
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+  // three extra entries hold the vertices pushed out by the last triangle until they are rescored
+  std::vector<uint32_t> cache;
+  std::vector<uint32_t> next_cache;
+  cache.reserve(CACHE_SIZE + 3);
+  next_cache.reserve(CACHE_SIZE + 3);
+
+  uint32_t best = 0;
+  uint32_t scan = 0;  // triangles before it have been emitted
+  while (true) {
+    if (best == UINT32_MAX) {
+      // no cached vertex has triangles left, continue with the next unemitted triangle
+      while (scan < triangle_count && emitted[scan]) {
+        scan++;
+      }
+      if (scan == triangle_count) {
+        break;
+      }
+      best = scan;
+    }
+
+    emitted[best] = 1;
+    const uint32_t* triangle = &indices[best * 3];
+    result.insert(result.end(), triangle, triangle + 3);
+
+    // degenerate triangles use a vertex more than once
+    next_cache.clear();
+    for (uint32_t corner = 0; corner < 3; corner++) {
+      if (std::find(next_cache.begin(), next_cache.end(), triangle[corner]) == next_cache.end()) {
+        next_cache.push_back(triangle[corner]);
+      }
+    }
+    for (uint32_t v : cache) {
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+        next_cache.push_back(v);
+      }
+    }
+    for (uint32_t corner = 0; corner < 3; corner++) {
+      uint32_t v = triangle[corner];
+      // move the triangle behind the vertex's remaining ones
+      uint32_t* begin = &vertex_triangles[first_triangle[v]];
+      uint32_t* last = begin + --remaining[v];
+      std::swap(*std::find(begin, last + 1, best), *last);
+    }
+
+    // rescore the cached vertices, the ones falling out of the cache lose their position score
+    for (uint32_t i = 0; i < next_cache.size(); i++) {
+      uint32_t v = next_cache[i];
+      cache_position[v] = i < CACHE_SIZE ? i : NOT_CACHED;
+      float score = scoreVertex(cache_position[v], remaining[v]);
+      float delta = score - vertex_scores[v];
+      vertex_scores[v] = score;
+      for (uint32_t j = 0; j < remaining[v]; j++) {
+        triangle_scores[vertex_triangles[first_triangle[v] + j]] += delta;
+      }
+    }
+    if (next_cache.size() > CACHE_SIZE) {
+      next_cache.resize(CACHE_SIZE);
+    }
+    std::swap(cache, next_cache);
+
+    best = UINT32_MAX;
+    float best_score = -1.0f;
+    for (uint32_t v : cache) {
+      for (uint32_t j = 0; j < remaining[v]; j++) {
+        uint32_t t = vertex_triangles[first_triangle[v] + j];
+        if (triangle_scores[t] > best_score) {
+          best = t;
+          best_score = triangle_scores[t];
+        }
+      }
+    }
+  }
+
+  std::copy(result.begin(), result.end(), indices.begin());
+}
+
+std::vector<uint32_t> optimizeVertexFetch(std::span<uint32_t> indices, uint32_t vertex_count) {
+  std::vector<uint32_t> remap(vertex_count, UINT32_MAX);
+  uint32_t next = 0;
+  for (uint32_t& index : indices) {
+    if (remap[index] == UINT32_MAX) {
+      remap[index] = next++;
+    }
+    index = remap[index];
+  }
+  return remap;
+}
+}  // namespace TE
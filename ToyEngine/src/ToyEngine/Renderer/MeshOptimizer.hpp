@@ -0,0 +1,23 @@
+#pragma once
+
+#include <span>
+
+#include "tepch.hpp"
+
+namespace TE {
+// Average vertex shader invocations per triangle with a FIFO post-transform cache of the given
+// size, between 0.5 for large regular grids and 3 without any reuse.
+float computeAcmr(std::span<const uint32_t> indices, uint32_t vertex_count,
+                  uint32_t cache_size = 16);
+
+// Reorders the triangles so vertices are reused while they are still in the post-transform cache.
+// Greedy linear-time algorithm by Tom Forsyth: every vertex is scored by its position in a
+// modeled LRU cache and by its number of remaining triangles, the next triangle is the one with
+// the highest score among those using cached vertices.
+void optimizeVertexCache(std::span<uint32_t> indices, uint32_t vertex_count);
+
+// Renumbers the vertices in the order the triangles first use them, so vertex fetches walk the
+// vertex buffer forwards. Returns the new index of every vertex, UINT32_MAX for vertices no
+// triangle uses.
+std::vector<uint32_t> optimizeVertexFetch(std::span<uint32_t> indices, uint32_t vertex_count);
+}  // namespace TE
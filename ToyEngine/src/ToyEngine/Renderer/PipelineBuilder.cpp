@@ -0,0 +1,344 @@
+#include "PipelineBuilder.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/BindlessRegistry.hpp"
+#include "ToyEngine/Renderer/Helpers.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+size_t GraphicsPipelineDesc::hash() const {
+  size_t seed = 0;
+  hashCombine(seed, vertex_shader);
+  hashCombine(seed, fragment_shader);
+
+  hashCombine(seed, vertex_layout.stride);
+  hashCombine(seed, vertex_layout.input_rate);
+  for (auto& attribute : vertex_layout.attributes) {
+    hashCombine(seed, attribute.location);
+    hashCombine(seed, attribute.format);
+    hashCombine(seed, attribute.offset);
+  }
+
+  hashCombine(seed, topology);
+  hashCombine(seed, polygon_mode);
+  hashCombine(seed, static_cast<VkCullModeFlags>(cull_mode));
+  hashCombine(seed, front_face);
+
+  hashCombine(seed, blend_enable);
+  hashCombine(seed, src_color_blend);
+  hashCombine(seed, dst_color_blend);
+  hashCombine(seed, color_blend_op);
+  hashCombine(seed, src_alpha_blend);
+  hashCombine(seed, dst_alpha_blend);
+  hashCombine(seed, alpha_blend_op);
+
+  hashCombine(seed, depth_test);
+  hashCombine(seed, depth_write);
+  hashCombine(seed, depth_compare);
+
+  hashCombine(seed, static_cast<VkRenderPass>(render_pass));
+  for (auto format : color_formats) {
+    hashCombine(seed, format);
+  }
+  hashCombine(seed, depth_format);
+
+  return seed;
+}
+
+PipelineBuilder::PipelineBuilder(const Device& device, vk::PipelineCache cache,
+                                 vk::DescriptorSetLayout descriptor_set_layout)
+    : device(device), cache(cache), descriptor_set_layout(descriptor_set_layout) {}
+
+PipelineBuilder::~PipelineBuilder() {
+  auto device = this->device.getDevice();
+
+  for (auto& [desc, pipeline] : pipelines) {
+    device.destroyPipeline(pipeline.pipeline);
+  }
+
+  for (auto& [shader, pipeline] : compute_pipelines) {
+    device.destroyPipeline(pipeline.pipeline);
+  }
+
+  for (auto& entry : layouts) {
+    device.destroyPipelineLayout(entry.layout);
+  }
+}
+
+const GraphicsPipeline& PipelineBuilder::get(const GraphicsPipelineDesc& desc) {
+  auto it = pipelines.find(desc);
+  if (it == pipelines.end()) {
+    it = pipelines.emplace(desc, create(desc)).first;
+  }
+  return it->second;
+}
+
+const ComputePipeline& PipelineBuilder::getCompute(const std::string& shader) {
+  auto it = compute_pipelines.find(shader);
+  if (it == compute_pipelines.end()) {
+    it = compute_pipelines.emplace(shader, createCompute(shader)).first;
+  }
+  return it->second;
+}
+
+GraphicsPipeline PipelineBuilder::create(const GraphicsPipelineDesc& desc) {
+  auto device = this->device.getDevice();
+
+  auto& vertex_shader = getShader(desc.vertex_shader, ShaderType::VERTEX);
+  auto& fragment_shader = getShader(desc.fragment_shader, ShaderType::FRAGMENT);
+  validateBindings(desc.vertex_shader, vertex_shader.getReflection());
+  validateBindings(desc.fragment_shader, fragment_shader.getReflection());
+
+  // a single range covering the blocks of all stages, so one pushConstants() updates them all
+  GraphicsPipeline result;
+  for (auto* reflection : {&vertex_shader.getReflection(), &fragment_shader.getReflection()}) {
+    if (reflection->push_constant_size == 0) {
+      continue;
+    }
+    uint32_t end = reflection->push_constant_offset + reflection->push_constant_size;
+    result.push_constant_stages |= reflection->stage;
+    result.push_constant_size = std::max(result.push_constant_size, end);
+  }
+
+  std::vector<vk::PushConstantRange> push_constants;
+  if (result.push_constant_size > 0) {
+    push_constants.push_back({
+        .stageFlags = result.push_constant_stages,
+        .offset = 0,
+        .size = result.push_constant_size,
+    });
+  }
+  result.layout = getLayout(push_constants);
+
+  VertexLayout vertex_layout = resolveVertexLayout(desc, vertex_shader.getReflection());
+
+  std::array<vk::DynamicState, 2> dynamic_states{
+      vk::DynamicState::eViewport,
+      vk::DynamicState::eScissor,
+  };
+
+  vk::PipelineDynamicStateCreateInfo dynamic_state{
+      .dynamicStateCount = static_cast<uint32_t>(dynamic_states.size()),
+      .pDynamicStates = dynamic_states.data(),
+  };
+
+  vk::VertexInputBindingDescription binding_desc{
+      .binding = 0,
+      .stride = vertex_layout.stride,
+      .inputRate = vertex_layout.input_rate,
+  };
+
+  std::vector<vk::VertexInputAttributeDescription> attribute_descs;
+  for (auto& attribute : vertex_layout.attributes) {
+    attribute_descs.push_back({
+        .location = attribute.location,
+        .binding = 0,
+        .format = attribute.format,
+        .offset = attribute.offset,
+    });
+  }
+
+  bool has_vertices = !attribute_descs.empty();
+  vk::PipelineVertexInputStateCreateInfo vertex_input{
+      .vertexBindingDescriptionCount = has_vertices ? 1u : 0u,
+      .pVertexBindingDescriptions = &binding_desc,
+      .vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descs.size()),
+      .pVertexAttributeDescriptions = attribute_descs.data(),
+  };
+
+  vk::PipelineInputAssemblyStateCreateInfo input_assembly{
+      .topology = desc.topology,
+      .primitiveRestartEnable = vk::False,
+  };
+
+  vk::PipelineViewportStateCreateInfo viewport{
+      .viewportCount = 1,
+      .scissorCount = 1,
+  };
+
+  vk::PipelineRasterizationStateCreateInfo rasterization{
+      .depthClampEnable = vk::False,
+      .rasterizerDiscardEnable = vk::False,
+      .polygonMode = desc.polygon_mode,
+      .cullMode = desc.cull_mode,
+      .frontFace = desc.front_face,
+      .depthBiasEnable = vk::False,
+      .lineWidth = 1.0f,
+  };
+
+  vk::PipelineMultisampleStateCreateInfo multisampling{
+      .rasterizationSamples = vk::SampleCountFlagBits::e1,
+      .sampleShadingEnable = vk::False,
+  };
+
+  vk::PipelineDepthStencilStateCreateInfo depth_stencil{
+      .depthTestEnable = desc.depth_test,
+      .depthWriteEnable = desc.depth_write,
+      .depthCompareOp = desc.depth_compare,
+  };
+
+  vk::PipelineColorBlendAttachmentState blend_attachment{
+      .blendEnable = desc.blend_enable,
+      .srcColorBlendFactor = desc.src_color_blend,
+      .dstColorBlendFactor = desc.dst_color_blend,
+      .colorBlendOp = desc.color_blend_op,
+      .srcAlphaBlendFactor = desc.src_alpha_blend,
+      .dstAlphaBlendFactor = desc.dst_alpha_blend,
+      .alphaBlendOp = desc.alpha_blend_op,
+      .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+                        vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA,
+  };
+  std::vector<vk::PipelineColorBlendAttachmentState> blend_attachments(
+      std::max<size_t>(desc.color_formats.size(), 1), blend_attachment);
+
+  vk::PipelineColorBlendStateCreateInfo color_blending{
+      .logicOpEnable = vk::False,
+      .attachmentCount = static_cast<uint32_t>(blend_attachments.size()),
+      .pAttachments = blend_attachments.data(),
+  };
+
+  std::array<vk::PipelineShaderStageCreateInfo, 2> shader_stages{
+      vertex_shader.getStageCreateInfo(device),
+      fragment_shader.getStageCreateInfo(device),
+  };
+
+  vk::GraphicsPipelineCreateInfo pipeline_info{
+      .stageCount = static_cast<uint32_t>(shader_stages.size()),
+      .pStages = shader_stages.data(),
+      .pVertexInputState = &vertex_input,
+      .pInputAssemblyState = &input_assembly,
+      .pViewportState = &viewport,
+      .pRasterizationState = &rasterization,
+      .pMultisampleState = &multisampling,
+      .pDepthStencilState = &depth_stencil,
+      .pColorBlendState = &color_blending,
+      .pDynamicState = &dynamic_state,
+      .layout = result.layout,
+      .renderPass = desc.render_pass,
+      .subpass = 0,
+  };
+
+  vk::Result res;
+  std::tie(res, result.pipeline) = device.createGraphicsPipeline(cache, pipeline_info);
+
+  for (auto& stage : shader_stages) {
+    device.destroyShaderModule(stage.module);
+  }
+
+  if (res != vk::Result::eSuccess) {
+    throw std::runtime_error("failed to create graphics pipeline!");
+  }
+
+  return result;
+}
+
+ComputePipeline PipelineBuilder::createCompute(const std::string& name) {
+  auto device = this->device.getDevice();
+
+  auto& shader = getShader(name, ShaderType::COMPUTE);
+  auto& reflection = shader.getReflection();
+  validateBindings(name, reflection);
+
+  ComputePipeline result;
+  std::vector<vk::PushConstantRange> push_constants;
+  if (reflection.push_constant_size > 0) {
+    result.push_constant_size = reflection.push_constant_offset + reflection.push_constant_size;
+    push_constants.push_back({
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        .offset = 0,
+        .size = result.push_constant_size,
+    });
+  }
+  result.layout = getLayout(push_constants);
+
+  vk::ComputePipelineCreateInfo pipeline_info{
+      .stage = shader.getStageCreateInfo(device),
+      .layout = result.layout,
+  };
+
+  vk::Result res;
+  std::tie(res, result.pipeline) = device.createComputePipeline(cache, pipeline_info);
+
+  device.destroyShaderModule(pipeline_info.stage.module);
+
+  if (res != vk::Result::eSuccess) {
+    throw std::runtime_error("failed to create compute pipeline!");
+  }
+
+  return result;
+}
+
+const Shader& PipelineBuilder::getShader(const std::string& name, ShaderType type) {
+  auto it = shaders.find(name);
+  if (it == shaders.end()) {
+    it = shaders.emplace(name, Shader(name, type)).first;
+  }
+  return it->second;
+}
+
+vk::PipelineLayout PipelineBuilder::getLayout(
+    const std::vector<vk::PushConstantRange>& push_constants) {
+  for (auto& entry : layouts) {
+    if (entry.push_constants == push_constants) {
+      return entry.layout;
+    }
+  }
+
+  uint32_t max_size = device.getProperties().limits.maxPushConstantsSize;
+  for (auto& range : push_constants) {
+    if (range.offset + range.size > max_size) {
+      throw std::runtime_error("push constants exceed maxPushConstantsSize!");
+    }
+  }
+
+  vk::PipelineLayoutCreateInfo layout_info{
+      .setLayoutCount = 1,
+      .pSetLayouts = &descriptor_set_layout,
+      .pushConstantRangeCount = static_cast<uint32_t>(push_constants.size()),
+      .pPushConstantRanges = push_constants.data(),
+  };
+
+  vk::PipelineLayout layout = device.getDevice().createPipelineLayout(layout_info);
+  layouts.push_back({push_constants, layout});
+  return layout;
+}
+
+void PipelineBuilder::validateBindings(const std::string& name,
+                                       const ShaderReflection& reflection) const {
+  for (auto& binding : reflection.bindings) {
+    if (binding.set != 0 || binding.binding > static_cast<uint32_t>(BindlessType::TEXTURE) ||
+        BindlessRegistry::getDescriptorType(static_cast<BindlessType>(binding.binding)) !=
+            binding.type) {
+      throw std::runtime_error(name + ": set " + std::to_string(binding.set) + " binding " +
+                               std::to_string(binding.binding) +
+                               " does not match the bindless layout");
+    }
+  }
+}
+
+VertexLayout PipelineBuilder::resolveVertexLayout(const GraphicsPipelineDesc& desc,
+                                                  const ShaderReflection& reflection) const {
+  // without an explicit layout the inputs are packed tightly in location order
+  if (desc.vertex_layout.attributes.empty()) {
+    VertexLayout layout{.input_rate = desc.vertex_layout.input_rate};
+    for (auto& input : reflection.inputs) {
+      layout.attributes.push_back({input.location, input.format, layout.stride});
+      layout.stride += input.size;
+    }
+    return layout;
+  }
+
+  for (auto& input : reflection.inputs) {
+    auto& attributes = desc.vertex_layout.attributes;
+    auto it = std::find_if(attributes.begin(), attributes.end(),
+                           [&](auto& attribute) { return attribute.location == input.location; });
+    if (it == attributes.end() || it->format != input.format) {
+      throw std::runtime_error(desc.vertex_shader + ": vertex input " +
+                               std::to_string(input.location) +
+                               " does not match the vertex layout");
+    }
+  }
+  return desc.vertex_layout;
+}
+}  // namespace TE
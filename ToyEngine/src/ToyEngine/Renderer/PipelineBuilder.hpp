@@ -0,0 +1,113 @@
+#pragma once
+
+#include <unordered_map>
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/Device.hpp"
+#include "ToyEngine/Renderer/Shader.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+struct VertexAttribute {
+  uint32_t location;
+  vk::Format format;
+  uint32_t offset;
+
+  bool operator==(const VertexAttribute&) const = default;
+};
+
+struct VertexLayout {
+  uint32_t stride = 0;
+  vk::VertexInputRate input_rate = vk::VertexInputRate::eVertex;
+  std::vector<VertexAttribute> attributes;
+
+  bool operator==(const VertexLayout&) const = default;
+};
+
+// Full state of a graphics pipeline, equal descriptions share one vk::Pipeline.
+struct GraphicsPipelineDesc {
+  std::string vertex_shader;
+  std::string fragment_shader;
+  VertexLayout vertex_layout;
+
+  vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+  vk::PolygonMode polygon_mode = vk::PolygonMode::eFill;
+  vk::CullModeFlags cull_mode = vk::CullModeFlagBits::eBack;
+  vk::FrontFace front_face = vk::FrontFace::eClockwise;
+
+  bool blend_enable = false;
+  vk::BlendFactor src_color_blend = vk::BlendFactor::eSrcAlpha;
+  vk::BlendFactor dst_color_blend = vk::BlendFactor::eOneMinusSrcAlpha;
+  vk::BlendOp color_blend_op = vk::BlendOp::eAdd;
+  vk::BlendFactor src_alpha_blend = vk::BlendFactor::eOne;
+  vk::BlendFactor dst_alpha_blend = vk::BlendFactor::eZero;
+  vk::BlendOp alpha_blend_op = vk::BlendOp::eAdd;
+
+  bool depth_test = false;
+  bool depth_write = false;
+  vk::CompareOp depth_compare = vk::CompareOp::eLessOrEqual;
+
+  // render target
+  vk::RenderPass render_pass;
+  std::vector<vk::Format> color_formats;
+  vk::Format depth_format = vk::Format::eUndefined;
+
+  bool operator==(const GraphicsPipelineDesc&) const = default;
+  size_t hash() const;
+};
+
+struct GraphicsPipeline {
+  vk::Pipeline pipeline;
+  vk::PipelineLayout layout;
+  vk::ShaderStageFlags push_constant_stages;
+  uint32_t push_constant_size = 0;
+};
+
+struct ComputePipeline {
+  vk::Pipeline pipeline;
+  vk::PipelineLayout layout;
+  uint32_t push_constant_size = 0;
+};
+
+// Creates pipelines on demand, graphics pipelines are cached by the hash of their description.
+// Pipeline layouts are derived from the shaders' reflection: the global bindless set plus tightly
+// sized push constant ranges.
+class PipelineBuilder {
+ public:
+  PipelineBuilder(const Device& device, vk::PipelineCache cache,
+                  vk::DescriptorSetLayout descriptor_set_layout);
+  ~PipelineBuilder();
+
+  // The reference stays valid for the lifetime of the builder.
+  const GraphicsPipeline& get(const GraphicsPipelineDesc& desc);
+  const ComputePipeline& getCompute(const std::string& shader);
+
+  inline size_t getPipelineCount() const { return pipelines.size(); }
+
+ private:
+  struct DescHash {
+    inline size_t operator()(const GraphicsPipelineDesc& desc) const { return desc.hash(); }
+  };
+
+  struct LayoutEntry {
+    std::vector<vk::PushConstantRange> push_constants;
+    vk::PipelineLayout layout;
+  };
+
+  GraphicsPipeline create(const GraphicsPipelineDesc& desc);
+  ComputePipeline createCompute(const std::string& shader);
+  const Shader& getShader(const std::string& name, ShaderType type);
+  vk::PipelineLayout getLayout(const std::vector<vk::PushConstantRange>& push_constants);
+  void validateBindings(const std::string& name, const ShaderReflection& reflection) const;
+  VertexLayout resolveVertexLayout(const GraphicsPipelineDesc& desc,
+                                   const ShaderReflection& reflection) const;
+
+  const Device& device;
+  vk::PipelineCache cache;
+  vk::DescriptorSetLayout descriptor_set_layout;
+  std::vector<LayoutEntry> layouts;
+  std::unordered_map<GraphicsPipelineDesc, GraphicsPipeline, DescHash> pipelines;
+  std::unordered_map<std::string, ComputePipeline> compute_pipelines;
+  std::unordered_map<std::string, Shader> shaders;
+};
+}  // namespace TE
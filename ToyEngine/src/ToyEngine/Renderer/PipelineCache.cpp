@@ -0,0 +1,103 @@
+#include "PipelineCache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <vulkan/vulkan.hpp>
+
+namespace TE {
+namespace {
+// prepended to the driver's cache data, the Vulkan header does not include the driver version
+struct FileHeader {
+  char magic[4];
+  uint32_t driver_version;
+  uint64_t data_size;
+};
+
+constexpr char MAGIC[4] = {'T', 'E', 'P', 'C'};
+}  // namespace
+
+PipelineCache::PipelineCache(const Device& device, const std::string& path)
+    : device{device}, path{path} {
+  auto data = load();
+
+  vk::PipelineCacheCreateInfo cache_info{
+      .initialDataSize = data.size(),
+      .pInitialData = data.data(),
+  };
+  cache = device.getDevice().createPipelineCache(cache_info);
+}
+
+PipelineCache::~PipelineCache() {
+  try {
+    save();
+  } catch (const std::exception& e) {
+    std::cerr << "Failed to save pipeline cache: " << e.what() << std::endl;
+  }
+  device.getDevice().destroyPipelineCache(cache);
+}
+
+void PipelineCache::save() const {
+  auto data = device.getDevice().getPipelineCacheData(cache);
+
+  FileHeader header{
+      .driver_version = device.getProperties().driverVersion,
+      .data_size = data.size(),
+  };
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+
+  // write to a temporary file first so a crash never leaves a truncated cache behind
+  std::string tmp_path = path + ".tmp";
+  std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    throw std::runtime_error("failed to open file: " + tmp_path);
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(data.data()), data.size());
+  file.close();
+
+  std::filesystem::rename(tmp_path, path);
+}
+
+std::vector<char> PipelineCache::load() const {
+  std::ifstream file(path, std::ios::ate | std::ios::binary);
+  if (!file.is_open()) {
+    return {};
+  }
+
+  size_t file_size = static_cast<size_t>(file.tellg());
+  if (file_size < sizeof(FileHeader)) {
+    return {};
+  }
+
+  FileHeader header;
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.driver_version != device.getProperties().driverVersion ||
+      header.data_size != file_size - sizeof(FileHeader)) {
+    return {};
+  }
+
+  std::vector<char> data(header.data_size);
+  file.read(data.data(), data.size());
+
+  if (!isCompatible(data)) {
+    return {};
+  }
+  return data;
+}
+
+bool PipelineCache::isCompatible(const std::vector<char>& data) const {
+  VkPipelineCacheHeaderVersionOne header;
+  if (data.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+
+  const auto& properties = device.getProperties();
+  return header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+         std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(),
+                     VK_UUID_SIZE) == 0;
+}
+}  // namespace TE
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/Device.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// VkPipelineCache that is loaded from disk and written back on destruction. Cache files created
+// by a different GPU or driver version are discarded.
+class PipelineCache {
+ public:
+  PipelineCache(const Device& device, const std::string& path);
+  ~PipelineCache();
+
+  void save() const;
+
+  inline vk::PipelineCache get() const { return cache; }
+
+ private:
+  std::vector<char> load() const;
+  bool isCompatible(const std::vector<char>& data) const;
+
+  const Device& device;
+  std::string path;
+  vk::PipelineCache cache;
+};
+}  // namespace TE
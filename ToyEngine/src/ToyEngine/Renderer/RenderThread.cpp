@@ -0,0 +1,73 @@
+#include "RenderThread.hpp"
+
+#include "ToyEngine/Renderer/GraphicsContext.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+void RenderPacket::execute() const {
+  for (auto& command : commands) {
+    command();
+  }
+}
+
+RenderThread::RenderThread() : thread{[this] { run(); }} {}
+
+RenderThread::~RenderThread() {
+  published.fetch_or(STOP, std::memory_order_release);
+  published.notify_one();
+  thread.join();
+}
+
+RenderPacket& RenderThread::beginPacket() {
+  uint64_t frame = published.load(std::memory_order_relaxed);
+
+  // the packet is free once the render thread has finished the frame that used it last
+  uint64_t done = rendered.load(std::memory_order_acquire);
+  while (frame - done >= PACKET_COUNT) {
+    rendered.wait(done, std::memory_order_acquire);
+    done = rendered.load(std::memory_order_acquire);
+  }
+
+  if (failed.load(std::memory_order_acquire)) {
+    std::rethrow_exception(error);
+  }
+  return packets[frame % PACKET_COUNT];
+}
+
+void RenderThread::publish() {
+  published.fetch_add(1, std::memory_order_release);
+  published.notify_one();
+}
+
+void RenderThread::run() {
+  auto& ctx = GraphicsContext::get();
+
+  for (uint64_t frame = 0;; frame++) {
+    uint64_t value = published.load(std::memory_order_acquire);
+    while ((value & ~STOP) == frame) {
+      if (value & STOP) {
+        return;
+      }
+      published.wait(value, std::memory_order_acquire);
+      value = published.load(std::memory_order_acquire);
+    }
+
+    auto& packet = packets[frame % PACKET_COUNT];
+    if (!failed.load(std::memory_order_relaxed)) {
+      try {
+        ctx.beginFrame();
+        packet.execute();
+        ctx.endFrame();
+      } catch (...) {
+        error = std::current_exception();
+        failed.store(true, std::memory_order_release);
+      }
+    }
+    // after a failure the packets are only recycled, so the simulation gets to see the error
+    packet.clear();
+
+    rendered.store(frame + 1, std::memory_order_release);
+    rendered.notify_one();
+  }
+}
+}  // namespace TE
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+#include "tepch.hpp"
+
+namespace TE {
+// Render commands of one frame, built by the simulation and left untouched once published. The
+// commands only read data they captured, e.g. the draw lists, camera and UI of the frame.
+class RenderPacket {
+ public:
+  inline void submit(std::function<void()> command) { commands.push_back(std::move(command)); }
+  // Runs the commands in submission order.
+  void execute() const;
+  inline void clear() { commands.clear(); }
+
+ private:
+  std::vector<std::function<void()>> commands;
+};
+
+// Records, submits and presents frames on a dedicated thread. The simulation fills one of two
+// packets while the render thread executes the other, so frame N + 1 is simulated while frame N is
+// recorded and a slow fence wait or present no longer stalls the simulation. The handoff is a pair
+// of frame counters the threads wait on, no lock is taken.
+class RenderThread {
+ public:
+  RenderThread();
+  // Renders the packets published so far before joining the thread.
+  ~RenderThread();
+
+  // Returns the packet of the next frame once the render thread is done with the frame before the
+  // previous one. Rethrows the exceptions thrown by render commands.
+  RenderPacket& beginPacket();
+  // Hands the packet returned by beginPacket() over to the render thread.
+  void publish();
+
+  static constexpr uint32_t PACKET_COUNT = 2;
+
+ private:
+  void run();
+
+  std::array<RenderPacket, PACKET_COUNT> packets;
+  // packets handed over, STOP is set once no more follow
+  std::atomic<uint64_t> published = 0;
+  std::atomic<uint64_t> rendered = 0;
+  // set by the render thread before it counts the failed packet as rendered
+  std::atomic<bool> failed = false;
+  std::exception_ptr error;
+  std::thread thread;
+
+  static constexpr uint64_t STOP = 1ull << 63;
+};
+}  // namespace TE
@@ -2,7 +2,12 @@
 
 #include <sys/types.h>
 
-#include "ToyEngine/Renderer/Buffer.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "ToyEngine/Core/Application.hpp"
+#include "ToyEngine/Renderer/Frustum.hpp"
 #include "ToyEngine/Renderer/GraphicsContext.hpp"
 #include "glm/ext/matrix_transform.hpp"
 
@@ -10,49 +15,704 @@ namespace TE {
 
 struct DrawParameters {
   glm::mat4 viewProjection;
+  uint32_t transforms;   // storage buffer holding the world matrices
+  uint32_t draw_buffer;  // storage buffer holding the draws
+  uint32_t draws;        // index of the scene's first DrawData, gl_InstanceIndex is added
+};
+
+// instanced.vert InstanceParameters
+struct InstanceParameters {
+  glm::mat4 viewProjection;
+  uint32_t instances;  // storage buffer holding the instance rows
+  uint32_t first;      // first row of the batch
+  uint32_t stride;     // distance between the batch's row arrays
+  uint32_t texture;
+};
+
+// triangle.vert DrawData
+struct DrawData {
   uint32_t world;
+  uint32_t texture;
 };
 
-Scene::Scene() : ubo{Buffer::createUniformBuffer(sizeof(glm::mat4))} {
-  auto& ctx = TE::GraphicsContext::get();
+// cull.comp CullObject
+struct CullObject {
+  glm::vec4 sphere;  // local bounding sphere
+  uint32_t world;
+  uint32_t texture;
+  uint32_t slot;  // first output index of the object's group
+  uint32_t group;
+  uint32_t index_count;
+  uint32_t first_index;
+  int32_t vertex_offset;
+  uint32_t padding;
+};
 
-  glm::mat4 world = glm::translate(glm::mat4(1.0f), glm::vec3(0.1f, 0.2f, 0.0f));
-  ubo.write(&world, sizeof(glm::mat4), 0);
+struct CullParameters {
+  glm::vec4 planes[6];
+  uint32_t frame_data;  // storage buffer holding the objects
+  uint32_t objects;
+  uint32_t object_count;
+  uint32_t output;
+  uint32_t commands;  // offsets into the output buffer in uints
+  uint32_t counts;
+  uint32_t transforms;  // storage buffer holding the world matrices
+};
 
-  vk::DescriptorBufferInfo buffer_info{
-      .buffer = ubo.getBuffer(),
-      .offset = 0,
-      .range = sizeof(glm::mat4),
+namespace {
+constexpr uint32_t CULL_GROUP_SIZE = 64;
+constexpr uint32_t MIN_CULL_CAPACITY = 1024;
+constexpr uint32_t MIN_WORLD_CAPACITY = 1024;
+// draw data, indirect command and at most one group count per draw
+constexpr vk::DeviceSize CULL_BYTES_PER_DRAW =
+    sizeof(DrawData) + sizeof(vk::DrawIndexedIndirectCommand) + sizeof(uint32_t);
+}  // namespace
+
+// Everything record() reads, copied by draw() so the simulation may change the scene while the
+// render thread records the frame.
+struct Scene::FramePacket {
+  // an instanced batch with instances
+  struct Batch {
+    const GraphicsPipeline* pipeline;
+    MeshRange range;
+    uint32_t texture;
+    uint32_t count;
+    uint32_t first;
+    uint32_t stride;
   };
-  vk::WriteDescriptorSet write_set{
-      .dstSet = ctx.getDescriptorSet(),
-      .dstBinding = 0,
-      .dstArrayElement = 0,
-      .descriptorCount = 1,
-      .descriptorType = vk::DescriptorType::eUniformBuffer,
-      .pBufferInfo = &buffer_info,
+
+  glm::mat4 view_projection;
+  std::array<glm::vec4, 6> planes;
+  uint32_t draw_count;
+  bool gpu_counts;
+
+  // input of the culling pass, or the draws already culled on the CPU
+  std::vector<CullObject> objects;
+  const ComputePipeline* cull_pipeline;
+  std::vector<DrawData> draws;
+  std::vector<vk::DrawIndexedIndirectCommand> commands;
+  std::vector<DrawGroup> groups;
+  std::vector<Batch> batches;
+
+  // world matrices of the changed ranges, packed
+  uint32_t world_capacity;
+  std::vector<glm::mat4> worlds;
+  std::vector<TransformHierarchy::Range> world_ranges;
+
+  uint32_t instance_buffer;
+  InstanceBuffer::Upload instances;
+  std::vector<GeometryPool::Relocation> relocations;
+  vk::Buffer vertex_buffer;
+  vk::Buffer index_buffer;
+};
+
+Scene::Scene() {
+  for (auto& packet : packets) {
+    packet = std::make_unique<FramePacket>();
+  }
+}
+
+Scene::~Scene() {
+  auto& bindless = GraphicsContext::get().getBindlessRegistry();
+  for (auto& cull_buffer : cull_buffers) {
+    if (cull_buffer) {
+      bindless.release(cull_buffer->handle);
+    }
+  }
+  if (world_buffer) {
+    bindless.release(world_buffer->handle);
+  }
+}
+
+uint32_t Scene::addInstanced(const std::span<const Vertex> vertices,
+                             const std::span<const GeometryPool::IndexType> indices,
+                             const GraphicsPipeline* pipeline) {
+  if (!pipeline) {
+    auto& ctx = GraphicsContext::get();
+    GraphicsPipelineDesc desc = ctx.getDefaultPipelineDesc();
+    desc.vertex_shader = "instanced.vert";
+    pipeline = &ctx.getPipelineBuilder().get(desc);
+  }
+
+  uint32_t batch = instances.addBatch();
+  assert(batch == batches.size());
+  batches.push_back({.mesh = geometry.add(vertices, indices), .texture = 0, .pipeline = pipeline});
+  return batch;
+}
+
+Entity Scene::add(const std::span<const Vertex> vertices,
+                  const std::span<const GeometryPool::IndexType> indices,
+                  const GraphicsPipeline* pipeline) {
+  uint32_t mesh = geometry.add(vertices, indices);
+  uint32_t node = transforms.add();
+  uint32_t object = object_meshes.size();
+  Entity entity = world.create(
+      MeshRenderer{.mesh = mesh, .texture = 0, .pipeline = pipeline, .object = object},
+      TransformNode{.node = node});
+
+  object_meshes.push_back(mesh);
+  object_nodes.push_back(node);
+  object_entities.push_back(entity);
+  moved.push_back(0);
+  // node ids are reused, so they may lie below the node count
+  node_objects.resize(std::max<size_t>(node_objects.size(), node + 1), NO_OBJECT);
+  node_objects[node] = object;
+  bvh_dirty = true;
+  return entity;
+}
+
+void Scene::remove(Entity entity) {
+  uint32_t object = world.get<MeshRenderer>(entity).object;
+  world.destroy(entity);
+  if (!world.isAlive(entity)) {
+    releaseObject(object);
+  }
+}
+
+void Scene::releaseObject(uint32_t object) {
+  uint32_t node = object_nodes[object];
+  geometry.remove(object_meshes[object]);
+  transforms.remove(node);
+  node_objects[node] = NO_OBJECT;
+
+  // the BVH is rebuilt from all boxes, the moved objects are renumbered below
+  for (uint32_t moved_object : moved_objects) {
+    moved[moved_object] = 0;
+  }
+  moved_objects.clear();
+  bvh_dirty = true;
+
+  uint32_t last = object_meshes.size() - 1;
+  if (object != last) {
+    object_meshes[object] = object_meshes[last];
+    object_nodes[object] = object_nodes[last];
+    object_entities[object] = object_entities[last];
+    node_objects[object_nodes[object]] = object;
+    world.get<MeshRenderer>(object_entities[object]).object = object;
+  }
+  object_meshes.pop_back();
+  object_nodes.pop_back();
+  object_entities.pop_back();
+  moved.pop_back();
+}
+
+void Scene::releaseDestroyed() {
+  // every object belongs to an entity with a MeshRenderer unless it has been destroyed
+  if (world.count<MeshRenderer>() == object_entities.size()) {
+    return;
+  }
+  for (uint32_t object = object_entities.size(); object-- > 0;) {
+    if (!world.isAlive(object_entities[object])) {
+      releaseObject(object);
+    }
+  }
+}
+
+uint32_t Scene::buildGroups() {
+  groups.clear();
+  draw_groups.clear();
+
+  // consecutive entities mostly share a pipeline and scenes use few, the search stays short
+  uint32_t group = 0;
+  world.each<const MeshRenderer, const TransformNode>(
+      [&](Entity, const MeshRenderer& renderer, const TransformNode&) {
+        if (group >= groups.size() || groups[group].pipeline != renderer.pipeline) {
+          auto it = std::find_if(groups.begin(), groups.end(), [&](const DrawGroup& existing) {
+            return existing.pipeline == renderer.pipeline;
+          });
+          if (it == groups.end()) {
+            groups.push_back({.pipeline = renderer.pipeline, .first = 0, .count = 0, .visible = 0});
+            it = groups.end() - 1;
+          }
+          group = it - groups.begin();
+        }
+        groups[group].count++;
+        draw_groups.push_back(group);
+      });
+
+  uint32_t first = 0;
+  for (auto& draw_group : groups) {
+    draw_group.first = first;
+    first += draw_group.count;
+  }
+  return first;
+}
+
+void Scene::markMoved() {
+  for (auto& range : transforms.getChangedRanges()) {
+    for (uint32_t index = range.first; index < range.first + range.count; index++) {
+      uint32_t node = transforms.getNode(index);
+      uint32_t object = node < node_objects.size() ? node_objects[node] : NO_OBJECT;
+      if (object != NO_OBJECT && !moved[object]) {
+        moved[object] = 1;
+        moved_objects.push_back(object);
+      }
+    }
+  }
+}
+
+void Scene::updateBvh() {
+  auto getWorldBox = [&](uint32_t object) {
+    return transformAabb(transforms.getWorld(object_nodes[object]),
+                         geometry.getBox(object_meshes[object]));
   };
-  ctx.getDevice().updateDescriptorSets(write_set, nullptr);
+
+  if (bvh_dirty) {
+    std::vector<Aabb> boxes(object_meshes.size());
+    for (uint32_t object = 0; object < boxes.size(); object++) {
+      boxes[object] = getWorldBox(object);
+    }
+    bvh.build(boxes);
+    bvh_dirty = false;
+  } else {
+    for (uint32_t object : moved_objects) {
+      bvh.update(object, getWorldBox(object));
+    }
+    bvh.refit();
+  }
+
+  for (uint32_t object : moved_objects) {
+    moved[object] = 0;
+  }
+  moved_objects.clear();
+}
+
+void Scene::extractWorlds(FramePacket& packet) {
+  auto worlds = transforms.getWorlds();
+  packet.worlds.clear();
+  packet.world_ranges.clear();
+
+  // the render thread grows the buffer to the packet's capacity, which invalidates its contents
+  TransformHierarchy::Range all{0, static_cast<uint32_t>(worlds.size())};
+  std::span<const TransformHierarchy::Range> ranges = transforms.getChangedRanges();
+  if (world_capacity == 0 || world_capacity < worlds.size()) {
+    uint32_t capacity = std::max(world_capacity, MIN_WORLD_CAPACITY);
+    while (capacity < worlds.size()) {
+      capacity *= 2;
+    }
+    world_capacity = capacity;
+    ranges = {&all, 1};
+  }
+  packet.world_capacity = world_capacity;
+
+  for (auto& range : ranges) {
+    if (range.count == 0) {
+      continue;
+    }
+    packet.worlds.insert(packet.worlds.end(), worlds.begin() + range.first,
+                         worlds.begin() + range.first + range.count);
+    packet.world_ranges.push_back(range);
+  }
+}
+
+void Scene::uploadWorlds(vk::CommandBuffer cmd, const FramePacket& packet) {
+  auto& ctx = GraphicsContext::get();
+  auto& bindless = ctx.getBindlessRegistry();
+
+  // the frame's fence has been waited on, so the buffer retired by its last run is idle
+  retired_world_buffers.resize(GraphicsContext::MAX_FRAMES_IN_FLIGHT);
+  retired_world_buffers[ctx.getFrameIndex()].reset();
+
+  if (!world_buffer || world_buffer->capacity < packet.world_capacity) {
+    if (world_buffer) {
+      bindless.release(world_buffer->handle);
+      retired_world_buffers[ctx.getFrameIndex()] = std::move(world_buffer->buffer);
+    }
+
+    Buffer buffer{
+        sizeof(glm::mat4) * packet.world_capacity,
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        0,
+    };
+    auto handle = bindless.registerStorageBuffer({
+        .buffer = buffer.getBuffer(),
+        .offset = 0,
+        .range = VK_WHOLE_SIZE,
+    });
+    bindless.writeDescriptors();
+    world_buffer = WorldBuffer{std::move(buffer), handle, packet.world_capacity};
+  }
+
+  if (packet.worlds.empty()) {
+    return;
+  }
+
+  // stage the changed matrices in frame memory and copy them into place
+  auto& frame_allocator = ctx.getFrameAllocator();
+  auto staging = frame_allocator.allocate<glm::mat4>(packet.worlds.size());
+  std::memcpy(staging.data, packet.worlds.data(), sizeof(glm::mat4) * packet.worlds.size());
+  vk::DeviceSize src_offset = frame_allocator.getFrameOffset() + staging.offset;
+  std::vector<vk::BufferCopy> copies;
+  for (auto& range : packet.world_ranges) {
+    copies.push_back({
+        .srcOffset = src_offset,
+        .dstOffset = sizeof(glm::mat4) * range.first,
+        .size = sizeof(glm::mat4) * range.count,
+    });
+    src_offset += sizeof(glm::mat4) * range.count;
+  }
+
+  auto shader_stages =
+      vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eComputeShader;
+  // the previous frames may still read the matrices being overwritten
+  cmd.pipelineBarrier(shader_stages, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr,
+                      nullptr);
+  cmd.copyBuffer(frame_allocator.getBuffer(), world_buffer->buffer.getBuffer(), copies);
+  vk::MemoryBarrier barrier{
+      .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+      .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+  };
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, shader_stages, {}, barrier, nullptr,
+                      nullptr);
+}
+
+Scene::CullBuffer& Scene::getCullBuffer(uint32_t frame, uint32_t count) {
+  auto& ctx = GraphicsContext::get();
+  cull_buffers.resize(GraphicsContext::MAX_FRAMES_IN_FLIGHT);
+
+  auto& cull_buffer = cull_buffers[frame];
+  if (cull_buffer && cull_buffer->capacity >= count) {
+    return *cull_buffer;
+  }
+
+  uint32_t capacity = MIN_CULL_CAPACITY;
+  if (cull_buffer) {
+    capacity = cull_buffer->capacity;
+    ctx.getBindlessRegistry().release(cull_buffer->handle);
+  }
+  while (capacity < count) {
+    capacity *= 2;
+  }
+
+  // the frame's fence has been waited on, so the previous buffer is idle
+  Buffer buffer{
+      CULL_BYTES_PER_DRAW * capacity,
+      vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+          vk::BufferUsageFlagBits::eTransferDst,
+      0,
+  };
+  auto handle = ctx.getBindlessRegistry().registerStorageBuffer({
+      .buffer = buffer.getBuffer(),
+      .offset = 0,
+      .range = VK_WHOLE_SIZE,
+  });
+  // the frame is already being recorded, write the descriptor right away
+  ctx.getBindlessRegistry().writeDescriptors();
+
+  cull_buffer = CullBuffer{std::move(buffer), handle, capacity};
+  return *cull_buffer;
 }
 
 void Scene::draw() {
-  auto& ctx = TE::GraphicsContext::get();
+  auto& ctx = GraphicsContext::get();
+  auto& jobs = Application::get().getJobSystem();
+  auto& packet = *packets[packet_index];
+  packet_index = (packet_index + 1) % packets.size();
+
+  releaseDestroyed();
+  uint32_t draw_count = buildGroups();
+  transforms.update(&jobs);
+  markMoved();
+  extractWorlds(packet);
+
+  const glm::mat4& view_projection = camera.getViewProjection();
+  Frustum frustum{view_projection};
+  packet.view_projection = view_projection;
+  packet.planes = frustum.planes;
+  packet.draw_count = draw_count;
+  packet.gpu_counts = gpu_culling && ctx.supportsDrawIndirectCount() && draw_count > 0;
+  packet.objects.clear();
+  packet.draws.clear();
+  packet.commands.clear();
+
+  if (packet.gpu_counts) {
+    // the shader places the visible objects by group, their order here doesn't matter
+    packet.objects.resize(draw_count);
+    uint32_t i = 0;
+    world.each<const MeshRenderer, const TransformNode>(
+        [&](Entity, const MeshRenderer& renderer, const TransformNode& transform) {
+          uint32_t g = draw_groups[i];
+          auto& range = geometry.getRange(renderer.mesh);
+          packet.objects[i++] = {
+              .sphere = geometry.getBounds(renderer.mesh),
+              .world = transforms.getIndex(transform.node),
+              .texture = renderer.texture,
+              .slot = groups[g].first,
+              .group = g,
+              .index_count = range.index_count,
+              .first_index = range.first_index,
+              .vertex_offset = range.vertex_offset,
+          };
+        });
+    packet.cull_pipeline = &ctx.getPipelineBuilder().getCompute("cull.comp");
+  } else {
+    packet.draws.resize(draw_count);
+    packet.commands.resize(draw_count);
+
+    updateBvh();
+    bvh.cull(frustum, visible, &jobs);
+
+    // compact the visible draws of each group to the start of its range
+    uint32_t i = 0;
+    world.each<const MeshRenderer, const TransformNode>(
+        [&](Entity, const MeshRenderer& renderer, const TransformNode& transform) {
+          auto& group = groups[draw_groups[i++]];
+          if (!visible[renderer.object]) {
+            return;
+          }
+
+          uint32_t slot = group.first + group.visible++;
+          auto& range = geometry.getRange(renderer.mesh);
+          packet.draws[slot] = {
+              .world = transforms.getIndex(transform.node),
+              .texture = renderer.texture,
+          };
+          packet.commands[slot] = {
+              .indexCount = range.index_count,
+              .instanceCount = 1,
+              .firstIndex = range.first_index,
+              .vertexOffset = range.vertex_offset,
+              .firstInstance = slot,
+          };
+        });
+  }
+  packet.groups = groups;
+
+  packet.batches.clear();
+  for (uint32_t b = 0; b < batches.size(); b++) {
+    uint32_t count = instances.getCount(b);
+    if (count == 0) {
+      continue;
+    }
+    packet.batches.push_back({
+        .pipeline = batches[b].pipeline,
+        .range = geometry.getRange(batches[b].mesh),
+        .texture = batches[b].texture,
+        .count = count,
+        .first = instances.getOffset(b),
+        .stride = instances.getStride(b),
+    });
+  }
+  packet.instance_buffer = instances.getDescriptor().index;
+  instances.flush(packet.instances);
+
+  packet.relocations = geometry.flush();
+  packet.vertex_buffer = geometry.getVertexBuffer();
+  packet.index_buffer = geometry.getIndexBuffer();
+
+  Application::get().submit([this, &packet] { record(packet); });
+}
+
+void Scene::record(const FramePacket& packet) {
+  auto& ctx = GraphicsContext::get();
   auto cmd = ctx.getCommandBuffer();
-  ctx.beginPass();
-  cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, ctx.getPipelineLayout(), 0,
-                         ctx.getDescriptorSet(), nullptr);
+  auto& jobs = Application::get().getJobSystem();
+  auto& frame_allocator = ctx.getFrameAllocator();
+  uint32_t draw_count = packet.draw_count;
+
+  uploadWorlds(cmd, packet);
 
   DrawParameters draw_parameters{
-      .viewProjection = camera.getViewProjection(),
-      .world = 0,
+      .viewProjection = packet.view_projection,
+      .transforms = world_buffer->handle.index,
   };
-  cmd.pushConstants(ctx.getPipelineLayout(), vk::ShaderStageFlagBits::eVertex, 0,
-                    sizeof(DrawParameters), &draw_parameters);
 
-  for (auto& vertex_array : vertex_arrays) {
-    vertex_array.bind(cmd);
-    vertex_array.draw(cmd);
+  vk::Buffer indirect_buffer;
+  vk::DeviceSize commands_offset;
+  vk::DeviceSize counts_offset = 0;
+
+  if (packet.gpu_counts) {
+    auto& cull_buffer = getCullBuffer(ctx.getFrameIndex(), draw_count);
+    commands_offset = sizeof(DrawData) * cull_buffer.capacity;
+    counts_offset = commands_offset + sizeof(vk::DrawIndexedIndirectCommand) * cull_buffer.capacity;
+    indirect_buffer = cull_buffer.buffer.getBuffer();
+    draw_parameters.draw_buffer = cull_buffer.handle.index;
+    draw_parameters.draws = 0;
+
+    auto objects = frame_allocator.allocate<CullObject>(draw_count);
+    std::memcpy(objects.data, packet.objects.data(), sizeof(CullObject) * draw_count);
+
+    CullParameters cull_parameters{
+        .frame_data = frame_allocator.getDescriptor().index,
+        .objects = static_cast<uint32_t>(objects.offset / sizeof(CullObject)),
+        .object_count = draw_count,
+        .output = cull_buffer.handle.index,
+        .commands = static_cast<uint32_t>(commands_offset / sizeof(uint32_t)),
+        .counts = static_cast<uint32_t>(counts_offset / sizeof(uint32_t)),
+        .transforms = world_buffer->handle.index,
+    };
+    std::copy(packet.planes.begin(), packet.planes.end(), cull_parameters.planes);
+
+    auto& cull_pipeline = *packet.cull_pipeline;
+    ctx.record("Culling", [&](vk::CommandBuffer cmd) {
+      // the counts are zeroed for every frame, the frame's previous draws have completed
+      cmd.fillBuffer(indirect_buffer, counts_offset, sizeof(uint32_t) * packet.groups.size(), 0);
+      vk::MemoryBarrier clear_barrier{
+          .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+          .dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+      };
+      cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                          vk::PipelineStageFlagBits::eComputeShader, {}, clear_barrier, nullptr,
+                          nullptr);
+
+      cmd.bindPipeline(vk::PipelineBindPoint::eCompute, cull_pipeline.pipeline);
+      cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, cull_pipeline.layout, 0,
+                             ctx.getDescriptorSet(), nullptr);
+      cmd.pushConstants(cull_pipeline.layout, vk::ShaderStageFlagBits::eCompute, 0,
+                        cull_pipeline.push_constant_size, &cull_parameters);
+      cmd.dispatch((draw_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+      vk::MemoryBarrier cull_barrier{
+          .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+          .dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead |
+                           vk::AccessFlagBits::eShaderRead,
+      };
+      cmd.pipelineBarrier(
+          vk::PipelineStageFlagBits::eComputeShader,
+          vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader, {},
+          cull_barrier, nullptr, nullptr);
+    });
+  } else {
+    auto draws = frame_allocator.allocate<DrawData>(draw_count);
+    auto commands = frame_allocator.allocate<vk::DrawIndexedIndirectCommand>(draw_count);
+    std::memcpy(draws.data, packet.draws.data(), sizeof(DrawData) * draw_count);
+    std::memcpy(commands.data, packet.commands.data(),
+                sizeof(vk::DrawIndexedIndirectCommand) * draw_count);
+    indirect_buffer = frame_allocator.getBuffer();
+    commands_offset = frame_allocator.getFrameOffset() + commands.offset;
+    draw_parameters.draw_buffer = frame_allocator.getDescriptor().index;
+    draw_parameters.draws = draws.offset / sizeof(DrawData);
+  }
+
+  GeometryPool::record(cmd, packet.relocations);
+  InstanceBuffer::record(cmd, packet.instances);
+
+  // groups first, then the instanced batches
+  draw_items.clear();
+  for (uint32_t g = 0; g < packet.groups.size(); g++) {
+    if (packet.gpu_counts || packet.groups[g].visible > 0) {
+      draw_items.push_back(g);
+    }
+  }
+  for (uint32_t b = 0; b < packet.batches.size(); b++) {
+    draw_items.push_back(packet.groups.size() + b);
+  }
+
+  InstanceParameters instance_parameters{
+      .viewProjection = packet.view_projection,
+      .instances = packet.instance_buffer,
+  };
+  // records the draw items [begin, end) into a buffer starting with the default pipeline bound
+  auto recordDraws = [&](vk::CommandBuffer cmd, uint32_t begin, uint32_t end) {
+    const GraphicsPipeline* bound_pipeline = &ctx.getDefaultPipeline();
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, bound_pipeline->layout, 0,
+                           ctx.getDescriptorSet(), nullptr);
+    GeometryPool::bind(cmd, packet.vertex_buffer, packet.index_buffer);
+
+    auto bindPipeline = [&](const GraphicsPipeline* pipeline) {
+      if (pipeline == bound_pipeline) {
+        return;
+      }
+      cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline->pipeline);
+      // layouts with different push constant ranges disturb the set binding
+      if (pipeline->layout != bound_pipeline->layout) {
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline->layout, 0,
+                               ctx.getDescriptorSet(), nullptr);
+      }
+      bound_pipeline = pipeline;
+    };
+
+    for (uint32_t i = begin; i < end; i++) {
+      uint32_t item = draw_items[i];
+      if (item >= packet.groups.size()) {
+        auto& batch = packet.batches[item - packet.groups.size()];
+        bindPipeline(batch.pipeline);
+
+        InstanceParameters parameters = instance_parameters;
+        parameters.first = batch.first;
+        parameters.stride = batch.stride;
+        parameters.texture = batch.texture;
+        assert(batch.pipeline->push_constant_size <= sizeof(InstanceParameters));
+        cmd.pushConstants(batch.pipeline->layout, batch.pipeline->push_constant_stages, 0,
+                          batch.pipeline->push_constant_size, &parameters);
+
+        cmd.drawIndexed(batch.range.index_count, batch.count, batch.range.first_index,
+                        batch.range.vertex_offset, 0);
+        continue;
+      }
+
+      auto& group = packet.groups[item];
+      auto* pipeline = group.pipeline ? group.pipeline : &ctx.getDefaultPipeline();
+      bindPipeline(pipeline);
+
+      // the reflected block may be smaller than the padded struct
+      assert(pipeline->push_constant_size <= sizeof(DrawParameters));
+      cmd.pushConstants(pipeline->layout, pipeline->push_constant_stages, 0,
+                        pipeline->push_constant_size, &draw_parameters);
+
+      vk::DeviceSize offset =
+          commands_offset + sizeof(vk::DrawIndexedIndirectCommand) * group.first;
+      if (packet.gpu_counts) {
+        cmd.drawIndexedIndirectCountKHR(indirect_buffer, offset, indirect_buffer,
+                                        counts_offset + sizeof(uint32_t) * item, group.count,
+                                        sizeof(vk::DrawIndexedIndirectCommand));
+      } else {
+        cmd.drawIndexedIndirect(indirect_buffer, offset, group.visible,
+                                sizeof(vk::DrawIndexedIndirectCommand));
+      }
+    }
+  };
+
+  // secondary buffers only pay off with enough draws to outweigh the jobs, now and then the other
+  // mode is recorded to measure it, parallel once the inline cost per item is known
+  uint32_t item_count = draw_items.size();
+  uint32_t job_count = std::min(item_count, jobs.getThreadCount());
+  bool parallel = job_count > 1 && item_count >= parallel_draws.load(std::memory_order_relaxed);
+  if (job_count > 1 && record_timing.frame++ % RECORD_PROBE_INTERVAL == 0 &&
+      (parallel || record_timing.item_seconds)) {
+    parallel = !parallel;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  if (parallel) {
+    ctx.beginPass("Scene", vk::SubpassContents::eSecondaryCommandBuffers);
+    ctx.recordParallel(jobs, item_count, recordDraws);
+  } else {
+    ctx.beginPass("Scene");
+    recordDraws(cmd, 0, item_count);
   }
   ctx.endPass();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  updateRecordTiming(parallel, job_count, elapsed.count());
+}
+
+void Scene::updateRecordTiming(bool parallel, uint32_t job_count, double seconds) {
+  uint32_t item_count = draw_items.size();
+  if (item_count == 0) {
+    return;
+  }
+  auto blend = [](std::optional<double>& average, double sample) {
+    average = average ? *average + (sample - *average) * RECORD_TIMING_WEIGHT : sample;
+  };
+
+  auto& timing = record_timing;
+  if (!parallel) {
+    blend(timing.item_seconds, seconds / item_count);
+  } else {
+    // what remains after the slowest job's share of the items
+    uint32_t job_items = (item_count + job_count - 1) / job_count;
+    blend(timing.parallel_seconds, std::max(0.0, seconds - *timing.item_seconds * job_items));
+  }
+  if (!timing.item_seconds || !timing.parallel_seconds || *timing.item_seconds <= 0.0) {
+    return;
+  }
+
+  // inline: n * item, parallel: fixed + n * item / threads
+  uint32_t thread_count = Application::get().getJobSystem().getThreadCount();
+  double saved_per_item = *timing.item_seconds * (1.0 - 1.0 / thread_count);
+  double threshold = std::ceil(*timing.parallel_seconds / saved_per_item);
+  parallel_draws.store(
+      static_cast<uint32_t>(std::clamp(threshold, 2.0, static_cast<double>(UINT32_MAX))),
+      std::memory_order_relaxed);
 }
-}  // namespace TE
\ No newline at end of file
+}  // namespace TE
@@ -1,24 +1,177 @@
 #pragma once
 
+#include <atomic>
+#include <optional>
+
+#include "ToyEngine/ECS/World.hpp"
+#include "ToyEngine/Renderer/BindlessRegistry.hpp"
 #include "ToyEngine/Renderer/Buffer.hpp"
+#include "ToyEngine/Renderer/Bvh.hpp"
 #include "ToyEngine/Renderer/Camera.hpp"
-#include "ToyEngine/Renderer/VertexArray.hpp"
+#include "ToyEngine/Renderer/Components.hpp"
+#include "ToyEngine/Renderer/GeometryPool.hpp"
+#include "ToyEngine/Renderer/InstanceBuffer.hpp"
+#include "ToyEngine/Renderer/PipelineBuilder.hpp"
+#include "ToyEngine/Renderer/RenderThread.hpp"
+#include "ToyEngine/Renderer/TransformHierarchy.hpp"
 #include "tepch.hpp"
 
 namespace TE {
+// Draws the MeshRenderer entities of its World with one indirect draw per pipeline, the draw
+// lists are built by iterating the entities' chunks every frame. Meshes outside the camera
+// frustum are culled by a compute pass that compacts the indirect commands of the visible ones,
+// or on the CPU against a BVH of the meshes' world boxes if the device can't draw with
+// GPU-written counts. The shaders index the per-draw data through gl_InstanceIndex. Meshes with
+// many copies are registered as instanced batches instead, each drawn with one instanced draw.
+// Mesh transforms form a hierarchy whose world matrices persist on the GPU, only changed ones
+// are uploaded. Drawing is split in two: draw() culls and copies the frame's draw lists into a
+// packet, the render command it submits records the packet, possibly on the render thread.
 class Scene {
  public:
   Scene();
+  ~Scene();
+
+  // Once per frame, the render thread is at most one packet behind.
   void draw();
-  inline void add(const std::span<const VertexArray::VertexType> vertices,
-                  const std::span<const VertexArray::IndexType> indices) {
-    vertex_arrays.emplace_back(vertices, indices);
+  // Creates an entity with a MeshRenderer and a TransformNode, other components can be added
+  // through getWorld(). The pipeline comes from the PipelineBuilder, a null pipeline draws with
+  // the pass default.
+  Entity add(const std::span<const Vertex> vertices,
+             const std::span<const GeometryPool::IndexType> indices,
+             const GraphicsPipeline* pipeline = nullptr);
+  // Destroys an entity created by add() and releases its mesh, node and BVH object. Children of
+  // its node move to the node's parent. Entities destroyed through getWorld(), or while the world
+  // is being iterated, are released by the next draw().
+  void remove(Entity entity);
+  // relative to the entity's parent
+  inline void setTransform(Entity entity, const glm::mat4& transform) {
+    transforms.setLocal(getNode(entity), transform);
+  }
+  // The parent is a node of getTransforms(), e.g. the node of another entity.
+  inline void setParent(Entity entity, uint32_t node) {
+    transforms.setParent(getNode(entity), node);
+  }
+  inline uint32_t getNode(Entity entity) { return world.get<TransformNode>(entity).node; }
+  inline void setTexture(Entity entity, TextureHandle texture) {
+    world.get<MeshRenderer>(entity).texture = texture.index;
+  }
+  inline TransformHierarchy& getTransforms() { return transforms; }
+  inline World& getWorld() { return world; }
+  inline void setGpuCulling(bool enabled) { gpu_culling = enabled; }
+  // Draw items from which the pass is recorded in parallel, measured while drawing.
+  inline uint32_t getParallelDraws() const {
+    return parallel_draws.load(std::memory_order_relaxed);
+  }
+
+  // Returns the batch used to add instances of the mesh. A null pipeline draws with the pass
+  // default using instanced.vert, other pipelines need a vertex shader reading the same rows.
+  uint32_t addInstanced(const std::span<const Vertex> vertices,
+                        const std::span<const GeometryPool::IndexType> indices,
+                        const GraphicsPipeline* pipeline = nullptr);
+  // Returns the instance index used to update the instance's transform.
+  inline uint32_t addInstance(uint32_t batch, const glm::mat4& transform) {
+    return instances.add(batch, transform);
+  }
+  inline void setInstanceTransform(uint32_t batch, uint32_t instance, const glm::mat4& transform) {
+    instances.set(batch, instance, transform);
+  }
+  inline void setInstanceTexture(uint32_t batch, TextureHandle texture) {
+    batches[batch].texture = texture.index;
   }
 
   Camera camera{glm::vec3(0.0f, 0.0f, -5.0f), glm::vec3(0.0f, 0.0f, 0.0f)};
-  Buffer ubo;
 
  private:
-  std::vector<VertexArray> vertex_arrays;
+  // draws sharing a pipeline, a contiguous range of indirect commands
+  struct DrawGroup {
+    const GraphicsPipeline* pipeline;
+    uint32_t first;
+    uint32_t count;
+    uint32_t visible;  // written by the CPU culling only
+  };
+
+  // Output of the culling pass: draw data, indirect commands and one draw count per group.
+  struct CullBuffer {
+    Buffer buffer;
+    StorageBufferHandle handle;
+    uint32_t capacity;
+  };
+
+  struct InstanceBatch {
+    uint32_t mesh;  // id in the geometry pool
+    uint32_t texture;
+    const GraphicsPipeline* pipeline;
+  };
+
+  // World matrices in hierarchy order, kept across frames.
+  struct WorldBuffer {
+    Buffer buffer;
+    StorageBufferHandle handle;
+    uint32_t capacity;
+  };
+
+  // CPU time of recording the pass. Inline it grows with the draw items, in parallel the items
+  // are shared by the jobs but the jobs and secondary buffers add a fixed cost.
+  struct RecordTiming {
+    std::optional<double> item_seconds;      // inline, per draw item
+    std::optional<double> parallel_seconds;  // parallel, the fixed part
+    uint32_t frame = 0;
+  };
+
+  static constexpr uint32_t NO_OBJECT = UINT32_MAX;
+  // frames between recordings in the mode not chosen, keeps both timings up to date
+  static constexpr uint32_t RECORD_PROBE_INTERVAL = 64;
+  static constexpr double RECORD_TIMING_WEIGHT = 1.0 / 16.0;
+
+  struct FramePacket;
+
+  void releaseObject(uint32_t object);
+  void releaseDestroyed();
+  uint32_t buildGroups();
+  void markMoved();
+  void updateBvh();
+  void extractWorlds(FramePacket& packet);
+  // render side, only touches the GPU objects below and the packet
+  void record(const FramePacket& packet);
+  void uploadWorlds(vk::CommandBuffer cmd, const FramePacket& packet);
+  void updateRecordTiming(bool parallel, uint32_t job_count, double seconds);
+  CullBuffer& getCullBuffer(uint32_t frame, uint32_t count);
+
+  World world;
+  GeometryPool geometry;
+
+  TransformHierarchy transforms;
+  std::vector<uint32_t> node_objects;  // NO_OBJECT for nodes added through getTransforms()
+  uint32_t world_capacity = 0;  // of the buffer the render side keeps up with
+  std::optional<WorldBuffer> world_buffer;
+  std::vector<std::optional<Buffer>> retired_world_buffers;  // one per frame in flight
+
+  // rebuilt every frame, draw_groups holds the group of each entity in iteration order
+  std::vector<DrawGroup> groups;
+  std::vector<uint32_t> draw_groups;
+  std::vector<uint32_t> draw_items;  // visible groups, then the packet's instanced batches
+  RecordTiming record_timing;
+  // where the measured inline and parallel recording times meet, read by the simulation
+  std::atomic<uint32_t> parallel_draws = UINT32_MAX;
+
+  // World boxes for the CPU culling by MeshRenderer::object, refit with the objects moved since
+  // the last CPU cull. Removing an entity moves the last object into its place.
+  Bvh bvh;
+  bool bvh_dirty = false;
+  std::vector<uint32_t> object_meshes;
+  std::vector<uint32_t> object_nodes;
+  std::vector<Entity> object_entities;
+  std::vector<uint8_t> moved;
+  std::vector<uint32_t> moved_objects;
+  std::vector<uint8_t> visible;
+
+  InstanceBuffer instances;
+  std::vector<InstanceBatch> batches;
+
+  bool gpu_culling = true;
+  std::vector<std::optional<CullBuffer>> cull_buffers;  // one per frame in flight
+
+  std::array<std::unique_ptr<FramePacket>, RenderThread::PACKET_COUNT> packets;
+  uint32_t packet_index = 0;
 };
-}  // namespace TE
\ No newline at end of file
+}  // namespace TE
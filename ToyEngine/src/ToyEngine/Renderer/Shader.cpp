@@ -5,45 +5,47 @@
 #include "tepch.hpp"
 
 namespace TE {
+namespace {
+vk::ShaderStageFlagBits getStage(ShaderType type) {
+  switch (type) {
+    case ShaderType::VERTEX:
+      return vk::ShaderStageFlagBits::eVertex;
+    case ShaderType::FRAGMENT:
+      return vk::ShaderStageFlagBits::eFragment;
+    case ShaderType::COMPUTE:
+      return vk::ShaderStageFlagBits::eCompute;
+    default:
+      throw std::runtime_error("ShaderType not implemented!");
+  }
+}
+}  // namespace
 
 Shader::Shader(const std::string& filename, ShaderType type) : type(type) {
-  std::ifstream file("shaders/" + filename + ".spv", std::ios::ate | std::ios::binary);
+  file = Vfs::get().open("shaders/" + filename + ".spv");
+  auto bytes = file.getBytes();
 
-  if (!file.is_open()) {
-    throw std::runtime_error("failed to open file: " + filename);
+  if (bytes.size() % sizeof(uint32_t) != 0) {
+    throw std::runtime_error("invalid SPIR-V size: " + filename);
   }
+  // mappings and files in packs are aligned
+  code = {reinterpret_cast<const uint32_t*>(bytes.data()), bytes.size() / sizeof(uint32_t)};
 
-  size_t file_size = static_cast<size_t>(file.tellg());
-  code.resize(file_size);
-
-  file.seekg(0);
-  file.read(code.data(), file_size);
-
-  file.close();
+  reflection = ShaderReflection::reflect(code);
+  if (reflection.stage != getStage(type)) {
+    throw std::runtime_error("shader stage does not match its entry point: " + filename);
+  }
 }
 
 vk::PipelineShaderStageCreateInfo Shader::getStageCreateInfo(vk::Device device) const {
-  vk::ShaderStageFlagBits stage;
-  switch (type) {
-    case ShaderType::VERTEX:
-      stage = vk::ShaderStageFlagBits::eVertex;
-      break;
-    case ShaderType::FRAGMENT:
-      stage = vk::ShaderStageFlagBits::eFragment;
-      break;
-    default:
-      throw std::runtime_error("ShaderType not implemented!");
-  }
-
   vk::ShaderModuleCreateInfo module_info{
-      .codeSize = code.size(),
-      .pCode = reinterpret_cast<const uint32_t*>(code.data()),  // TODO: remove UB
+      .codeSize = code.size() * sizeof(uint32_t),
+      .pCode = code.data(),
   };
 
   vk::ShaderModule module = device.createShaderModule(module_info);
 
   vk::PipelineShaderStageCreateInfo stage_info{
-      .stage = stage,
+      .stage = reflection.stage,
       .module = module,
       .pName = "main",
   };
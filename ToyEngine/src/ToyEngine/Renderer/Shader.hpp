@@ -1,7 +1,10 @@
 #pragma once
 
+#include <span>
 #include <vulkan/vulkan.hpp>
 
+#include "ToyEngine/Core/Vfs.hpp"
+#include "ToyEngine/Renderer/ShaderReflection.hpp"
 #include "tepch.hpp"
 
 namespace TE {
@@ -17,10 +20,14 @@ class Shader {
   Shader(const std::string& filename, ShaderType type);
 
   vk::PipelineShaderStageCreateInfo getStageCreateInfo(vk::Device device) const;
+  inline const ShaderReflection& getReflection() const { return reflection; }
 
  private:
-  std::vector<char> code;
+  // the SPIR-V is read straight from the file
+  VfsFile file;
+  std::span<const uint32_t> code;
   ShaderType type;
+  ShaderReflection reflection;
 };
 
 }  // namespace TE
\ No newline at end of file
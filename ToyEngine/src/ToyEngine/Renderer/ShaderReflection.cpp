@@ -0,0 +1,412 @@
+#include "ShaderReflection.hpp"
+
+#include <array>
+#include <unordered_map>
+#include <vulkan/vulkan.hpp>
+
+#include "tepch.hpp"
+
+namespace TE {
+namespace {
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+constexpr uint32_t SPIRV_HEADER_SIZE = 5;
+
+// opcodes
+constexpr uint32_t OP_ENTRY_POINT = 15;
+constexpr uint32_t OP_TYPE_INT = 21;
+constexpr uint32_t OP_TYPE_FLOAT = 22;
+constexpr uint32_t OP_TYPE_VECTOR = 23;
+constexpr uint32_t OP_TYPE_MATRIX = 24;
+constexpr uint32_t OP_TYPE_IMAGE = 25;
+constexpr uint32_t OP_TYPE_SAMPLER = 26;
+constexpr uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+constexpr uint32_t OP_TYPE_ARRAY = 28;
+constexpr uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+constexpr uint32_t OP_TYPE_STRUCT = 30;
+constexpr uint32_t OP_TYPE_POINTER = 32;
+constexpr uint32_t OP_CONSTANT = 43;
+constexpr uint32_t OP_VARIABLE = 59;
+constexpr uint32_t OP_DECORATE = 71;
+constexpr uint32_t OP_MEMBER_DECORATE = 72;
+constexpr uint32_t OP_TYPE_ACCELERATION_STRUCTURE = 5341;
+
+// decorations
+constexpr uint32_t DECORATION_BUFFER_BLOCK = 3;
+constexpr uint32_t DECORATION_ARRAY_STRIDE = 6;
+constexpr uint32_t DECORATION_MATRIX_STRIDE = 7;
+constexpr uint32_t DECORATION_BUILT_IN = 11;
+constexpr uint32_t DECORATION_LOCATION = 30;
+constexpr uint32_t DECORATION_BINDING = 33;
+constexpr uint32_t DECORATION_DESCRIPTOR_SET = 34;
+constexpr uint32_t DECORATION_OFFSET = 35;
+
+// storage classes
+constexpr uint32_t STORAGE_UNIFORM_CONSTANT = 0;
+constexpr uint32_t STORAGE_INPUT = 1;
+constexpr uint32_t STORAGE_UNIFORM = 2;
+constexpr uint32_t STORAGE_PUSH_CONSTANT = 9;
+constexpr uint32_t STORAGE_STORAGE_BUFFER = 12;
+
+// execution models
+constexpr uint32_t EXECUTION_VERTEX = 0;
+constexpr uint32_t EXECUTION_FRAGMENT = 4;
+constexpr uint32_t EXECUTION_GL_COMPUTE = 5;
+
+// image dimensions and sampled operand
+constexpr uint32_t DIM_BUFFER = 5;
+constexpr uint32_t DIM_SUBPASS_DATA = 6;
+constexpr uint32_t IMAGE_STORAGE = 2;
+
+constexpr std::array<vk::Format, 4> FLOAT_FORMATS = {
+    vk::Format::eR32Sfloat,
+    vk::Format::eR32G32Sfloat,
+    vk::Format::eR32G32B32Sfloat,
+    vk::Format::eR32G32B32A32Sfloat,
+};
+constexpr std::array<vk::Format, 4> SINT_FORMATS = {
+    vk::Format::eR32Sint,
+    vk::Format::eR32G32Sint,
+    vk::Format::eR32G32B32Sint,
+    vk::Format::eR32G32B32A32Sint,
+};
+constexpr std::array<vk::Format, 4> UINT_FORMATS = {
+    vk::Format::eR32Uint,
+    vk::Format::eR32G32Uint,
+    vk::Format::eR32G32B32Uint,
+    vk::Format::eR32G32B32A32Uint,
+};
+
+struct Type {
+  uint32_t opcode = 0;
+  uint32_t width = 0;       // scalars
+  uint32_t signedness = 0;  // integers
+  uint32_t element = 0;     // vectors, matrices, arrays and pointers
+  uint32_t count = 0;       // vector components, matrix columns or the array length constant
+  uint32_t storage_class = 0;
+  uint32_t dim = 0;  // images
+  uint32_t sampled = 0;
+  std::vector<uint32_t> members;
+};
+
+struct Decorations {
+  uint32_t location = UINT32_MAX;
+  uint32_t binding = UINT32_MAX;
+  uint32_t set = 0;
+  uint32_t array_stride = 0;
+  bool built_in = false;
+  bool buffer_block = false;
+  std::vector<uint32_t> member_offsets;
+  std::vector<uint32_t> member_matrix_strides;
+};
+
+struct Variable {
+  uint32_t id;
+  uint32_t type;
+  uint32_t storage_class;
+};
+
+class Module {
+ public:
+  Module(std::span<const uint32_t> code);
+
+  ShaderReflection reflect() const;
+
+ private:
+  uint32_t sizeOf(uint32_t type_id, uint32_t matrix_stride = 0) const;
+  vk::Format formatOf(uint32_t type_id) const;
+  void reflectBinding(const Variable& variable, ShaderReflection& reflection) const;
+
+  inline const Type& type(uint32_t id) const {
+    auto it = types.find(id);
+    if (it == types.end()) {
+      throw std::runtime_error("SPIR-V references an unknown type");
+    }
+    return it->second;
+  }
+
+  inline const Decorations& decorationsOf(uint32_t id) const {
+    static const Decorations none;
+    auto it = decorations.find(id);
+    return it != decorations.end() ? it->second : none;
+  }
+
+  uint32_t execution_model = UINT32_MAX;
+  std::unordered_map<uint32_t, Type> types;
+  std::unordered_map<uint32_t, Decorations> decorations;
+  std::unordered_map<uint32_t, uint32_t> constants;
+  std::vector<Variable> variables;
+};
+
+Module::Module(std::span<const uint32_t> code) {
+  if (code.size() < SPIRV_HEADER_SIZE || code[0] != SPIRV_MAGIC) {
+    throw std::runtime_error("invalid SPIR-V module");
+  }
+
+  for (size_t i = SPIRV_HEADER_SIZE; i < code.size();) {
+    uint32_t opcode = code[i] & 0xFFFF;
+    uint32_t word_count = code[i] >> 16;
+    if (word_count == 0 || i + word_count > code.size()) {
+      throw std::runtime_error("truncated SPIR-V instruction");
+    }
+    auto op = code.subspan(i, word_count);
+    i += word_count;
+
+    switch (opcode) {
+      case OP_ENTRY_POINT:
+        if (execution_model == UINT32_MAX) {
+          execution_model = op[1];
+        }
+        break;
+      case OP_TYPE_INT:
+        types[op[1]] = {.opcode = opcode, .width = op[2], .signedness = op[3]};
+        break;
+      case OP_TYPE_FLOAT:
+        types[op[1]] = {.opcode = opcode, .width = op[2]};
+        break;
+      case OP_TYPE_VECTOR:
+      case OP_TYPE_MATRIX:
+      case OP_TYPE_ARRAY:
+        types[op[1]] = {.opcode = opcode, .element = op[2], .count = op[3]};
+        break;
+      case OP_TYPE_RUNTIME_ARRAY:
+      case OP_TYPE_SAMPLED_IMAGE:
+        types[op[1]] = {.opcode = opcode, .element = op[2]};
+        break;
+      case OP_TYPE_IMAGE:
+        types[op[1]] = {.opcode = opcode, .dim = op[3], .sampled = op[7]};
+        break;
+      case OP_TYPE_SAMPLER:
+      case OP_TYPE_ACCELERATION_STRUCTURE:
+        types[op[1]] = {.opcode = opcode};
+        break;
+      case OP_TYPE_STRUCT:
+        types[op[1]] = {.opcode = opcode, .members = {op.begin() + 2, op.end()}};
+        break;
+      case OP_TYPE_POINTER:
+        types[op[1]] = {.opcode = opcode, .element = op[3], .storage_class = op[2]};
+        break;
+      case OP_CONSTANT:
+        constants[op[2]] = op[3];
+        break;
+      case OP_VARIABLE:
+        variables.push_back({.id = op[2], .type = op[1], .storage_class = op[3]});
+        break;
+      case OP_DECORATE: {
+        auto& decoration = decorations[op[1]];
+        switch (op[2]) {
+          case DECORATION_BUFFER_BLOCK:
+            decoration.buffer_block = true;
+            break;
+          case DECORATION_ARRAY_STRIDE:
+            decoration.array_stride = op[3];
+            break;
+          case DECORATION_BUILT_IN:
+            decoration.built_in = true;
+            break;
+          case DECORATION_LOCATION:
+            decoration.location = op[3];
+            break;
+          case DECORATION_BINDING:
+            decoration.binding = op[3];
+            break;
+          case DECORATION_DESCRIPTOR_SET:
+            decoration.set = op[3];
+            break;
+        }
+        break;
+      }
+      case OP_MEMBER_DECORATE: {
+        auto& decoration = decorations[op[1]];
+        uint32_t member = op[2];
+        if (op[3] == DECORATION_OFFSET) {
+          decoration.member_offsets.resize(std::max<size_t>(decoration.member_offsets.size(),
+                                                            member + 1));
+          decoration.member_offsets[member] = op[4];
+        } else if (op[3] == DECORATION_MATRIX_STRIDE) {
+          decoration.member_matrix_strides.resize(
+              std::max<size_t>(decoration.member_matrix_strides.size(), member + 1));
+          decoration.member_matrix_strides[member] = op[4];
+        } else if (op[3] == DECORATION_BUILT_IN) {
+          decoration.built_in = true;
+        }
+        break;
+      }
+    }
+  }
+}
+
+ShaderReflection Module::reflect() const {
+  ShaderReflection reflection;
+  switch (execution_model) {
+    case EXECUTION_VERTEX:
+      reflection.stage = vk::ShaderStageFlagBits::eVertex;
+      break;
+    case EXECUTION_FRAGMENT:
+      reflection.stage = vk::ShaderStageFlagBits::eFragment;
+      break;
+    case EXECUTION_GL_COMPUTE:
+      reflection.stage = vk::ShaderStageFlagBits::eCompute;
+      break;
+    default:
+      throw std::runtime_error("unsupported SPIR-V execution model");
+  }
+
+  for (auto& variable : variables) {
+    switch (variable.storage_class) {
+      case STORAGE_INPUT: {
+        auto& decoration = decorationsOf(variable.id);
+        if (reflection.stage != vk::ShaderStageFlagBits::eVertex || decoration.built_in ||
+            decorationsOf(type(variable.type).element).built_in) {
+          break;
+        }
+        reflection.inputs.push_back({
+            .location = decoration.location,
+            .format = formatOf(type(variable.type).element),
+            .size = sizeOf(type(variable.type).element),
+        });
+        break;
+      }
+      case STORAGE_PUSH_CONSTANT: {
+        auto& pointee = type(type(variable.type).element);
+        auto& decoration = decorationsOf(type(variable.type).element);
+        uint32_t offset = UINT32_MAX;
+        for (uint32_t i = 0; i < pointee.members.size(); i++) {
+          offset = std::min(offset, decoration.member_offsets.at(i));
+        }
+        uint32_t size = sizeOf(type(variable.type).element);
+        reflection.push_constant_offset = pointee.members.empty() ? 0 : offset;
+        reflection.push_constant_size = size - reflection.push_constant_offset;
+        break;
+      }
+      case STORAGE_UNIFORM_CONSTANT:
+      case STORAGE_UNIFORM:
+      case STORAGE_STORAGE_BUFFER:
+        reflectBinding(variable, reflection);
+        break;
+    }
+  }
+
+  std::sort(reflection.inputs.begin(), reflection.inputs.end(),
+            [](auto& a, auto& b) { return a.location < b.location; });
+
+  return reflection;
+}
+
+void Module::reflectBinding(const Variable& variable, ShaderReflection& reflection) const {
+  auto& decoration = decorationsOf(variable.id);
+  if (decoration.binding == UINT32_MAX) {
+    return;
+  }
+
+  uint32_t type_id = type(variable.type).element;
+  uint32_t count = 1;
+  if (type(type_id).opcode == OP_TYPE_ARRAY) {
+    count = constants.at(type(type_id).count);
+    type_id = type(type_id).element;
+  } else if (type(type_id).opcode == OP_TYPE_RUNTIME_ARRAY) {
+    count = 0;
+    type_id = type(type_id).element;
+  }
+
+  auto& resource = type(type_id);
+  vk::DescriptorType descriptor_type;
+  switch (resource.opcode) {
+    case OP_TYPE_STRUCT:
+      if (variable.storage_class == STORAGE_STORAGE_BUFFER || decorationsOf(type_id).buffer_block) {
+        descriptor_type = vk::DescriptorType::eStorageBuffer;
+      } else {
+        descriptor_type = vk::DescriptorType::eUniformBuffer;
+      }
+      break;
+    case OP_TYPE_SAMPLED_IMAGE:
+      descriptor_type = vk::DescriptorType::eCombinedImageSampler;
+      break;
+    case OP_TYPE_SAMPLER:
+      descriptor_type = vk::DescriptorType::eSampler;
+      break;
+    case OP_TYPE_IMAGE:
+      if (resource.dim == DIM_BUFFER) {
+        descriptor_type = resource.sampled == IMAGE_STORAGE
+                              ? vk::DescriptorType::eStorageTexelBuffer
+                              : vk::DescriptorType::eUniformTexelBuffer;
+      } else if (resource.dim == DIM_SUBPASS_DATA) {
+        descriptor_type = vk::DescriptorType::eInputAttachment;
+      } else {
+        descriptor_type = resource.sampled == IMAGE_STORAGE ? vk::DescriptorType::eStorageImage
+                                                            : vk::DescriptorType::eSampledImage;
+      }
+      break;
+    case OP_TYPE_ACCELERATION_STRUCTURE:
+      descriptor_type = vk::DescriptorType::eAccelerationStructureKHR;
+      break;
+    default:
+      throw std::runtime_error("unsupported SPIR-V resource type");
+  }
+
+  reflection.bindings.push_back({
+      .set = decoration.set,
+      .binding = decoration.binding,
+      .type = descriptor_type,
+      .count = count,
+  });
+}
+
+uint32_t Module::sizeOf(uint32_t type_id, uint32_t matrix_stride) const {
+  auto& t = type(type_id);
+  switch (t.opcode) {
+    case OP_TYPE_INT:
+    case OP_TYPE_FLOAT:
+      return t.width / 8;
+    case OP_TYPE_VECTOR:
+      return t.count * sizeOf(t.element);
+    case OP_TYPE_MATRIX:
+      return t.count * (matrix_stride ? matrix_stride : sizeOf(t.element));
+    case OP_TYPE_ARRAY: {
+      uint32_t stride = decorationsOf(type_id).array_stride;
+      return constants.at(t.count) * (stride ? stride : sizeOf(t.element));
+    }
+    case OP_TYPE_RUNTIME_ARRAY:
+      return 0;
+    case OP_TYPE_STRUCT: {
+      auto& decoration = decorationsOf(type_id);
+      uint32_t size = 0;
+      for (uint32_t i = 0; i < t.members.size(); i++) {
+        uint32_t offset = i < decoration.member_offsets.size() ? decoration.member_offsets[i] : 0;
+        uint32_t stride =
+            i < decoration.member_matrix_strides.size() ? decoration.member_matrix_strides[i] : 0;
+        size = std::max(size, offset + sizeOf(t.members[i], stride));
+      }
+      return size;
+    }
+    default:
+      throw std::runtime_error("SPIR-V type has no size");
+  }
+}
+
+vk::Format Module::formatOf(uint32_t type_id) const {
+  auto& t = type(type_id);
+  uint32_t components = 1;
+  auto* scalar = &t;
+  if (t.opcode == OP_TYPE_VECTOR) {
+    components = t.count;
+    scalar = &type(t.element);
+  }
+
+  if (scalar->width != 32 || components > 4) {
+    throw std::runtime_error("unsupported vertex input type");
+  }
+  switch (scalar->opcode) {
+    case OP_TYPE_FLOAT:
+      return FLOAT_FORMATS[components - 1];
+    case OP_TYPE_INT:
+      return scalar->signedness ? SINT_FORMATS[components - 1] : UINT_FORMATS[components - 1];
+    default:
+      throw std::runtime_error("unsupported vertex input type");
+  }
+}
+}  // namespace
+
+ShaderReflection ShaderReflection::reflect(std::span<const uint32_t> code) {
+  return Module(code).reflect();
+}
+}  // namespace TE
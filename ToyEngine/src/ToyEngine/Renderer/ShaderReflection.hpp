@@ -0,0 +1,32 @@
+#pragma once
+
+#include <span>
+#include <vulkan/vulkan.hpp>
+
+#include "tepch.hpp"
+
+namespace TE {
+struct ReflectedBinding {
+  uint32_t set;
+  uint32_t binding;
+  vk::DescriptorType type;
+  uint32_t count;  // 0 for runtime sized arrays
+};
+
+struct ReflectedInput {
+  uint32_t location;
+  vk::Format format;
+  uint32_t size;
+};
+
+// Interface of a single SPIR-V entry point, parsed once when the shader is loaded.
+struct ShaderReflection {
+  vk::ShaderStageFlagBits stage{};
+  std::vector<ReflectedBinding> bindings;
+  std::vector<ReflectedInput> inputs;  // vertex stage only, sorted by location
+  uint32_t push_constant_offset = 0;
+  uint32_t push_constant_size = 0;
+
+  static ShaderReflection reflect(std::span<const uint32_t> code);
+};
+}  // namespace TE
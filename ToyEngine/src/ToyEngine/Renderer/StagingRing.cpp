@@ -0,0 +1,72 @@
+#include "StagingRing.hpp"
+
+#include <cstring>
+#include <vulkan/vulkan.hpp>
+
+namespace TE {
+StagingRing::StagingRing(VmaAllocator allocator, vk::DeviceSize capacity)
+    : allocator{allocator}, capacity{capacity} {
+  vk::BufferCreateInfo buffer_info{
+      .size = capacity,
+      .usage = vk::BufferUsageFlagBits::eTransferSrc,
+      .sharingMode = vk::SharingMode::eExclusive,
+  };
+
+  VmaAllocationCreateInfo alloc_info{};
+  alloc_info.usage = VMA_MEMORY_USAGE_AUTO;
+  alloc_info.flags =
+      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+  VmaAllocationInfo info;
+  auto err = vmaCreateBuffer(allocator, (VkBufferCreateInfo*)&buffer_info, &alloc_info, &buffer,
+                             &allocation, &info);
+  if (err != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create staging ring");
+  }
+  mapped = static_cast<std::byte*>(info.pMappedData);
+}
+
+StagingRing::~StagingRing() { vmaDestroyBuffer(allocator, buffer, allocation); }
+
+std::optional<StagingAllocation> StagingRing::allocate(vk::DeviceSize size,
+                                                       vk::DeviceSize alignment) {
+  assert(capacity % alignment == 0);
+
+  vk::DeviceSize start = (head + alignment - 1) & ~(alignment - 1);
+  if (start % capacity + size > capacity) {
+    // skip the remainder at the end of the buffer, allocations are never split
+    start = (start / capacity + 1) * capacity;
+  }
+
+  if (start + size - tail > capacity) {
+    return std::nullopt;
+  }
+
+  head = start + size;
+  return StagingAllocation{
+      .buffer = buffer,
+      .offset = start % capacity,
+      .data = mapped + start % capacity,
+  };
+}
+
+void StagingRing::write(const StagingAllocation& allocation, const void* data,
+                        vk::DeviceSize size) const {
+  std::memcpy(allocation.data, data, size);
+  vmaFlushAllocation(allocator, this->allocation, allocation.offset, size);
+}
+
+void StagingRing::fence(uint64_t value) {
+  if (hasUnfencedAllocations()) {
+    regions.push_back({.value = value, .end = head});
+    fenced_head = head;
+  }
+}
+
+void StagingRing::release(uint64_t completed_value) {
+  while (!regions.empty() && regions.front().value <= completed_value) {
+    tail = regions.front().end;
+    regions.pop_front();
+  }
+}
+}  // namespace TE
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <deque>
+#include <optional>
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/Allocator.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+struct StagingAllocation {
+  vk::Buffer buffer;
+  vk::DeviceSize offset;
+  void* data;
+};
+
+// Persistently mapped ring buffer for staging data. Allocations are retired in batches once the
+// timeline value they were fenced with has been reached.
+class StagingRing {
+ public:
+  StagingRing(VmaAllocator allocator, vk::DeviceSize capacity);
+  ~StagingRing();
+
+  // alignment has to be a power of two, returns std::nullopt if the ring is full
+  std::optional<StagingAllocation> allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+  // Writes data into the allocation and flushes it for non-coherent memory.
+  void write(const StagingAllocation& allocation, const void* data, vk::DeviceSize size) const;
+  // Assigns all allocations since the last fence to the given timeline value.
+  void fence(uint64_t value);
+  void release(uint64_t completed_value);
+
+  inline vk::DeviceSize getCapacity() const { return capacity; }
+  inline bool hasUnfencedAllocations() const { return head != fenced_head; }
+
+ private:
+  struct Region {
+    uint64_t value;
+    vk::DeviceSize end;
+  };
+
+  VmaAllocator allocator;
+  VkBuffer buffer;
+  VmaAllocation allocation;
+  std::byte* mapped;
+  vk::DeviceSize capacity;
+
+  // monotonically increasing offsets, the physical offset is taken modulo the capacity
+  vk::DeviceSize head = 0;
+  vk::DeviceSize tail = 0;
+  vk::DeviceSize fenced_head = 0;
+  std::deque<Region> regions;
+};
+}  // namespace TE
@@ -11,12 +11,23 @@
 namespace TE {
 
 SwapChain::SwapChain(GLFWwindow* window, const Device& device) : window{window}, device{device} {
+  updateFramebufferSize();
+  init();
+}
+
+SwapChain::SwapChain(vk::Extent2D extent, const Device& device, const Allocator& allocator)
+    : device{device}, allocator{allocator.getAllocator()}, extent{extent} {
   init();
 }
 
 SwapChain::~SwapChain() { destroy(); }
 
 void SwapChain::init() {
+  if (isHeadless()) {
+    initOffscreen();
+    return;
+  }
+
   auto capabilities = device.getGPU().getSurfaceCapabilitiesKHR(device.getSurface());
 
   // format
@@ -28,12 +39,13 @@ void SwapChain::init() {
   if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
     extent = capabilities.currentExtent;
   } else {
-    int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
+    uint64_t size = framebuffer_size.load(std::memory_order_relaxed);
+    uint32_t width = size >> 32;
+    uint32_t height = size & UINT32_MAX;
 
-    extent.width = std::clamp(static_cast<uint32_t>(width), capabilities.minImageExtent.width,
+    extent.width = std::clamp(width, capabilities.minImageExtent.width,
                               capabilities.maxImageExtent.width);
-    extent.height = std::clamp(static_cast<uint32_t>(height), capabilities.minImageExtent.height,
+    extent.height = std::clamp(height, capabilities.minImageExtent.height,
                                capabilities.maxImageExtent.height);
   }
 
@@ -68,14 +80,63 @@ void SwapChain::init() {
   }
 }
 
+void SwapChain::initOffscreen() {
+  format = vk::Format::eR8G8B8A8Srgb;
+
+  vk::ImageCreateInfo image_info{
+      .imageType = vk::ImageType::e2D,
+      .format = format,
+      .extent = {extent.width, extent.height, 1},
+      .mipLevels = 1,
+      .arrayLayers = 1,
+      .samples = vk::SampleCountFlagBits::e1,
+      .tiling = vk::ImageTiling::eOptimal,
+      .usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+      .sharingMode = vk::SharingMode::eExclusive,
+      .initialLayout = vk::ImageLayout::eUndefined,
+  };
+
+  VmaAllocationCreateInfo alloc_info{};
+  alloc_info.usage = VMA_MEMORY_USAGE_AUTO;
+  alloc_info.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+
+  for (uint32_t i = 0; i < OFFSCREEN_IMAGE_COUNT; i++) {
+    VkImage image;
+    VmaAllocation allocation;
+    auto err = vmaCreateImage(allocator, (VkImageCreateInfo*)&image_info, &alloc_info, &image,
+                              &allocation, nullptr);
+    if (err != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create offscreen image");
+    }
+
+    offscreen_images.push_back(image);
+    offscreen_allocations.push_back(allocation);
+    image_views.push_back(createImageView(device.getDevice(), image, format));
+  }
+}
+
 void SwapChain::resize() {
-  device.getDevice().waitIdle();
+  {
+    std::lock_guard lock{device.getQueueMutex()};
+    device.getDevice().waitIdle();
+  }
 
   destroy();
   init();
   createFramebuffers(render_pass);
 }
 
+void SwapChain::updateFramebufferSize() {
+  if (isHeadless()) {
+    return;
+  }
+
+  int width, height;
+  glfwGetFramebufferSize(window, &width, &height);
+  uint64_t size = uint64_t{static_cast<uint32_t>(width)} << 32 | static_cast<uint32_t>(height);
+  framebuffer_size.store(size, std::memory_order_relaxed);
+}
+
 void SwapChain::destroy() {
   destroyFramebuffers();
 
@@ -84,6 +145,12 @@ void SwapChain::destroy() {
   }
   image_views.clear();
 
+  for (size_t i = 0; i < offscreen_images.size(); i++) {
+    vmaDestroyImage(allocator, offscreen_images[i], offscreen_allocations[i]);
+  }
+  offscreen_images.clear();
+  offscreen_allocations.clear();
+
   for (auto semaphore : this->submit_semaphores) {
     device.getDevice().destroySemaphore(semaphore);
   }
@@ -91,6 +158,7 @@ void SwapChain::destroy() {
 
   if (this->swapchain) {
     device.getDevice().destroySwapchainKHR(this->swapchain);
+    this->swapchain = nullptr;
   }
 }
 
@@ -122,6 +190,12 @@ void SwapChain::destroyFramebuffers() {
 }
 
 void SwapChain::acquireNextImage(vk::Semaphore acquire_semaphore) {
+  if (isHeadless()) {
+    // offscreen images are reused round-robin, the frame fences keep them from being overwritten
+    current_image = (current_image + 1) % getImageCount();
+    return;
+  }
+
   vk::Result res;
   std::tie(res, current_image) =
       device.getDevice().acquireNextImageKHR(swapchain, UINT64_MAX, acquire_semaphore);
@@ -137,12 +211,16 @@ void SwapChain::acquireNextImage(vk::Semaphore acquire_semaphore) {
         .pWaitDstStageMask = psf,
     };
     // clear signaled semaphore
-    device.getQueue().submit(submit_info);
+    {
+      std::lock_guard lock{device.getQueueMutex()};
+      device.getQueue().submit(submit_info);
+    }
 
     resize();
     acquireNextImage(acquire_semaphore);
     return;
   } else if (res != vk::Result::eSuccess) {
+    std::lock_guard lock{device.getQueueMutex()};
     device.getQueue().waitIdle();
     throw std::runtime_error("Failed to acquire swap chain image!");
   }
@@ -2,17 +2,24 @@
 
 #include <GLFW/glfw3.h>
 
+#include <atomic>
 #include <vulkan/vulkan.hpp>
 
+#include "ToyEngine/Renderer/Allocator.hpp"
 #include "ToyEngine/Renderer/Device.hpp"
 
 namespace TE {
 class SwapChain {
  public:
   SwapChain(GLFWwindow* window, const Device& device);
+  // Headless swapchain rendering into VMA allocated offscreen images.
+  SwapChain(vk::Extent2D extent, const Device& device, const Allocator& allocator);
   ~SwapChain();
 
   void resize();
+  // Records the window's framebuffer size for the next resize(), which may run on the render
+  // thread. glfw only allows the query on the main thread.
+  void updateFramebufferSize();
   void createFramebuffers(vk::RenderPass render_pass);
   void destroyFramebuffers();
   void acquireNextImage(vk::Semaphore acquire_semaphore);
@@ -22,16 +29,24 @@ class SwapChain {
   inline vk::Extent2D getExtent() const { return extent; }
   inline uint32_t getImageCount() const { return image_views.size(); }
   inline uint32_t getImage() const { return current_image; }
+  inline bool isHeadless() const { return window == nullptr; }
+  inline vk::ImageLayout getFinalLayout() const {
+    return isHeadless() ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR;
+  }
+  inline vk::Image getOffscreenImage() const { return offscreen_images[current_image]; }
   inline vk::Semaphore getSubmitSemaphore() const { return submit_semaphores[current_image]; }
   inline vk::Framebuffer getFramebuffer() const { return framebuffers[current_image]; }
 
  private:
   void init();
+  void initOffscreen();
   void destroy();
   vk::SurfaceFormatKHR selectSurfaceFormat(const std::vector<vk::Format>& preferred);
 
-  GLFWwindow* window;
+  GLFWwindow* window = nullptr;
+  std::atomic<uint64_t> framebuffer_size = 0;  // width in the high, height in the low 32 bits
   const Device& device;
+  VmaAllocator allocator = nullptr;
   vk::RenderPass render_pass;
   vk::SwapchainKHR swapchain;
   vk::Format format;
@@ -39,7 +54,11 @@ class SwapChain {
   std::vector<vk::ImageView> image_views;
   std::vector<vk::Framebuffer> framebuffers;
   std::vector<vk::Semaphore> submit_semaphores;
-  uint32_t current_image;
+  std::vector<VkImage> offscreen_images;
+  std::vector<VmaAllocation> offscreen_allocations;
+  uint32_t current_image = 0;
+
+  static constexpr uint32_t OFFSCREEN_IMAGE_COUNT = 3;
 };
 
 }  // namespace TE
\ No newline at end of file
@@ -1,18 +1,194 @@
 #include "Texture.hpp"
 
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <span>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_handles.hpp>
 
 #include "Allocator.hpp"
 #include "Buffer.hpp"
 #include "GraphicsContext.hpp"
+#include "ToyEngine/Core/Vfs.hpp"
+#include "ToyEngine/Renderer/BlockCompression.hpp"
 #include "ToyEngine/Renderer/Helpers.hpp"
 #include "stb_image.h"
 #include "tepch.hpp"
 
 namespace TE {
-void createTextureSampler(vk::Sampler& sampler) {
+namespace {
+constexpr uint8_t KTX2_IDENTIFIER[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n',
+};
+
+// little-endian like the hosts the engine runs on
+struct Ktx2Header {
+  uint8_t identifier[12];
+  uint32_t vk_format;
+  uint32_t type_size;
+  uint32_t pixel_width;
+  uint32_t pixel_height;
+  uint32_t pixel_depth;
+  uint32_t layer_count;
+  uint32_t face_count;
+  uint32_t level_count;
+  uint32_t supercompression_scheme;
+  uint32_t dfd_byte_offset;
+  uint32_t dfd_byte_length;
+  uint32_t kvd_byte_offset;
+  uint32_t kvd_byte_length;
+  uint64_t sgd_byte_offset;
+  uint64_t sgd_byte_length;
+};
+static_assert(sizeof(Ktx2Header) == 80);
+
+struct Ktx2Level {
+  uint64_t byte_offset;
+  uint64_t byte_length;
+  uint64_t uncompressed_byte_length;
+};
+
+// KHR_DF_* values of the basic data format descriptor block
+constexpr uint32_t DFD_MODEL_RGBSDA = 1;
+constexpr uint32_t DFD_MODEL_BC1A = 128;
+constexpr uint32_t DFD_MODEL_BC3 = 130;
+constexpr uint32_t DFD_PRIMARIES_BT709 = 1;
+constexpr uint32_t DFD_TRANSFER_LINEAR = 1;
+constexpr uint32_t DFD_TRANSFER_SRGB = 2;
+constexpr uint32_t DFD_CHANNEL_ALPHA = 15;
+constexpr uint32_t DFD_SAMPLE_LINEAR = 0x10;
+
+struct DfdSample {
+  uint32_t channel;
+  uint32_t bit_offset;
+  uint32_t bit_length;
+  uint32_t upper;
+};
+
+// The data format descriptor KTX2 requires, a single basic block describing the texel blocks.
+std::vector<uint32_t> createDfd(vk::Format format) {
+  bool srgb = false;
+  uint32_t model;
+  std::vector<DfdSample> samples;
+  switch (format) {
+    case vk::Format::eR8G8B8A8Srgb:
+      srgb = true;
+      [[fallthrough]];
+    case vk::Format::eR8G8B8A8Unorm:
+      model = DFD_MODEL_RGBSDA;
+      samples = {{0, 0, 8, 255}, {1, 8, 8, 255}, {2, 16, 8, 255}, {DFD_CHANNEL_ALPHA, 24, 8, 255}};
+      break;
+    case vk::Format::eBc1RgbSrgbBlock:
+      srgb = true;
+      [[fallthrough]];
+    case vk::Format::eBc1RgbUnormBlock:
+      model = DFD_MODEL_BC1A;
+      samples = {{0, 0, 64, UINT32_MAX}};
+      break;
+    case vk::Format::eBc3SrgbBlock:
+      srgb = true;
+      [[fallthrough]];
+    case vk::Format::eBc3UnormBlock:
+      model = DFD_MODEL_BC3;
+      samples = {{DFD_CHANNEL_ALPHA, 0, 64, UINT32_MAX}, {0, 64, 64, UINT32_MAX}};
+      break;
+    default:
+      throw std::runtime_error("Can't save texture format " + vk::to_string(format));
+  }
+
+  auto block = getFormatBlock(format);
+  uint32_t block_size = 24 + 16 * samples.size();
+  std::vector<uint32_t> dfd{
+      4 + block_size,
+      0,  // Khronos vendor, basic descriptor type
+      2 | block_size << 16,
+      model | DFD_PRIMARIES_BT709 << 8 | (srgb ? DFD_TRANSFER_SRGB : DFD_TRANSFER_LINEAR) << 16,
+      (block.extent - 1) | (block.extent - 1) << 8,
+      block.size,
+      0,
+  };
+  for (auto& sample : samples) {
+    // alpha isn't sRGB encoded
+    uint32_t qualifiers = sample.channel == DFD_CHANNEL_ALPHA && srgb ? DFD_SAMPLE_LINEAR : 0;
+    uint32_t channel = sample.channel | qualifiers;
+    uint32_t bits = sample.bit_offset | (sample.bit_length - 1) << 16 | channel << 24;
+    // sample positions and lower bounds are 0
+    dfd.insert(dfd.end(), {bits, 0, 0, sample.upper});
+  }
+  return dfd;
+}
+
+float srgbToLinear(float value) {
+  return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float value) {
+  return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+// Loads the levels of a 2D texture without supercompression, the data format descriptor is
+// ignored as vkFormat describes the texels.
+TextureData loadKtx2(std::span<const uint8_t> bytes, const std::string& path) {
+  Ktx2Header header;
+  if (bytes.size() < sizeof(header)) {
+    throw std::runtime_error("Invalid KTX2 file " + path);
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (std::memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+    throw std::runtime_error("Invalid KTX2 file " + path);
+  }
+  if (header.supercompression_scheme != 0 || header.pixel_depth > 1 || header.layer_count > 1 ||
+      header.face_count != 1 || header.pixel_height == 0) {
+    throw std::runtime_error("Unsupported KTX2 texture " + path);
+  }
+
+  TextureData data{
+      .format = static_cast<vk::Format>(header.vk_format),
+      .width = header.pixel_width,
+      .height = header.pixel_height,
+      // zero asks for the mips to be generated
+      .mip_levels = std::max(header.level_count, 1u),
+  };
+  getFormatBlock(data.format);  // throws for unsupported formats
+
+  std::vector<Ktx2Level> levels(data.mip_levels);
+  size_t levels_size = levels.size() * sizeof(Ktx2Level);
+  if (bytes.size() < sizeof(header) + levels_size) {
+    throw std::runtime_error("Invalid KTX2 file " + path);
+  }
+  std::memcpy(levels.data(), bytes.data() + sizeof(header), levels_size);
+
+  data.pixels.resize(data.getMipOffset(data.mip_levels));
+  for (uint32_t i = 0; i < data.mip_levels; i++) {
+    auto& level = levels[i];
+    size_t size = data.getMipOffset(i + 1) - data.getMipOffset(i);
+    if (level.byte_length != size || level.byte_offset > bytes.size() ||
+        bytes.size() - level.byte_offset < size) {
+      throw std::runtime_error("Invalid KTX2 file " + path);
+    }
+    std::memcpy(data.pixels.data() + data.getMipOffset(i), bytes.data() + level.byte_offset, size);
+  }
+  return data;
+}
+
+bool supportsSampling(vk::Format format) {
+  auto features = GraphicsContext::get().getGPU().getFormatProperties(format).optimalTilingFeatures;
+  auto required = vk::FormatFeatureFlagBits::eSampledImage |
+                  vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+  return (features & required) == required;
+}
+
+bool supportsLinearBlits(vk::Format format) {
+  auto features = GraphicsContext::get().getGPU().getFormatProperties(format).optimalTilingFeatures;
+  auto required = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst |
+                  vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+  return (features & required) == required;
+}
+}  // namespace
+
+void createTextureSampler(vk::Sampler& sampler, uint32_t mip_levels) {
   vk::SamplerCreateInfo sampler_info{
       .magFilter = vk::Filter::eLinear,
       .minFilter = vk::Filter::eLinear,
@@ -26,7 +202,7 @@ void createTextureSampler(vk::Sampler& sampler) {
       .compareEnable = vk::False,
       .compareOp = vk::CompareOp::eAlways,
       .minLod = 0,
-      .maxLod = 0,
+      .maxLod = static_cast<float>(mip_levels),
       .borderColor = vk::BorderColor::eIntOpaqueBlack,
       .unnormalizedCoordinates = vk::False,
   };
@@ -37,28 +213,220 @@ void createTextureSampler(vk::Sampler& sampler) {
   }
 }
 
-Texture::Texture(const std::string& path, uint32_t index) {
-  auto& ctx = GraphicsContext::get();
+TextureData TextureData::load(const std::string& path) {
+  auto file = Vfs::get().open(path);
+  auto bytes = file.getBytes();
+  if (path.ends_with(".ktx2")) {
+    return loadKtx2(bytes, path);
+  }
 
   int width, height, channels;
-  stbi_uc* img = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+  stbi_uc* img = stbi_load_from_memory(bytes.data(), bytes.size(), &width, &height, &channels,
+                                       STBI_rgb_alpha);
   if (!img) {
     throw std::runtime_error("Failed to load texture " + path);
   }
 
-  auto buffer = Buffer::createStagingBuffer(width * height * 4);
-  buffer.write(img, width * height * 4, 0);
+  TextureData data{
+      .width = static_cast<uint32_t>(width),
+      .height = static_cast<uint32_t>(height),
+      .pixels = std::vector<uint8_t>(img, img + width * height * 4),
+  };
   stbi_image_free(img);
+  return data;
+}
+
+void TextureData::generateMips() {
+  uint32_t levels = getMipLevelCount(width, height);
+  if (mip_levels >= levels) {
+    return;
+  }
+  if (isBlockCompressed(format)) {
+    throw std::runtime_error("Can't generate the mips of block-compressed texture data");
+  }
+  bool srgb = format == vk::Format::eR8G8B8A8Srgb;
+  pixels.resize(getMipOffset(levels));
+
+  std::array<float, 256> to_linear;
+  for (uint32_t i = 0; i < to_linear.size(); i++) {
+    to_linear[i] = srgbToLinear(i / 255.0f);
+  }
+
+  for (uint32_t level = mip_levels; level < levels; level++) {
+    const uint8_t* src = pixels.data() + getMipOffset(level - 1);
+    uint8_t* dst = pixels.data() + getMipOffset(level);
+    uint32_t src_width = std::max(width >> (level - 1), 1u);
+    uint32_t src_height = std::max(height >> (level - 1), 1u);
+    uint32_t dst_width = std::max(src_width / 2, 1u);
+    uint32_t dst_height = std::max(src_height / 2, 1u);
+
+    for (uint32_t y = 0; y < dst_height; y++) {
+      // a source dimension of 1 is sampled twice
+      uint32_t rows[] = {2 * y, std::min(2 * y + 1, src_height - 1)};
+      for (uint32_t x = 0; x < dst_width; x++) {
+        uint32_t columns[] = {2 * x, std::min(2 * x + 1, src_width - 1)};
+        for (uint32_t channel = 0; channel < 4; channel++) {
+          float sum = 0.0f;
+          for (uint32_t row : rows) {
+            for (uint32_t column : columns) {
+              uint8_t value = src[(row * src_width + column) * 4 + channel];
+              // alpha is linear already
+              sum += channel == 3 || !srgb ? value / 255.0f : to_linear[value];
+            }
+          }
+          float average = channel == 3 || !srgb ? sum / 4.0f : linearToSrgb(sum / 4.0f);
+          dst[(y * dst_width + x) * 4 + channel] = static_cast<uint8_t>(average * 255.0f + 0.5f);
+        }
+      }
+    }
+  }
+  mip_levels = levels;
+}
+
+TextureData TextureData::decompress() const {
+  TextureData decompressed{
+      .format = getDecodedFormat(format),
+      .width = width,
+      .height = height,
+      .mip_levels = mip_levels,
+  };
+  decompressed.pixels.reserve(decompressed.getMipOffset(mip_levels));
+  for (uint32_t level = 0; level < mip_levels; level++) {
+    auto texels = decodeBlocks(format, pixels.data() + getMipOffset(level),
+                               std::max(width >> level, 1u), std::max(height >> level, 1u));
+    decompressed.pixels.insert(decompressed.pixels.end(), texels.begin(), texels.end());
+  }
+  return decompressed;
+}
+
+TextureData TextureData::compress() const {
+  if (format != vk::Format::eR8G8B8A8Srgb && format != vk::Format::eR8G8B8A8Unorm) {
+    throw std::runtime_error("Can't compress texture data of format " + vk::to_string(format));
+  }
+  bool srgb = format == vk::Format::eR8G8B8A8Srgb;
+  bool opaque = true;
+  for (size_t i = 3; i < pixels.size(); i += 4) {
+    opaque = opaque && pixels[i] == 255;
+  }
+
+  TextureData compressed{
+      .width = width,
+      .height = height,
+      .mip_levels = mip_levels,
+  };
+  if (opaque) {
+    compressed.format = srgb ? vk::Format::eBc1RgbSrgbBlock : vk::Format::eBc1RgbUnormBlock;
+  } else {
+    compressed.format = srgb ? vk::Format::eBc3SrgbBlock : vk::Format::eBc3UnormBlock;
+  }
+
+  compressed.pixels.reserve(compressed.getMipOffset(mip_levels));
+  for (uint32_t level = 0; level < mip_levels; level++) {
+    auto blocks = encodeBlocks(compressed.format, pixels.data() + getMipOffset(level),
+                               std::max(width >> level, 1u), std::max(height >> level, 1u));
+    compressed.pixels.insert(compressed.pixels.end(), blocks.begin(), blocks.end());
+  }
+  return compressed;
+}
+
+void TextureData::save(const std::string& path) const {
+  auto dfd = createDfd(format);
+  auto block = getFormatBlock(format);
+
+  Ktx2Header header{
+      .identifier = {},
+      .vk_format = static_cast<uint32_t>(format),
+      .type_size = 1,
+      .pixel_width = width,
+      .pixel_height = height,
+      .pixel_depth = 0,
+      .layer_count = 0,
+      .face_count = 1,
+      .level_count = mip_levels,
+      .supercompression_scheme = 0,
+      .dfd_byte_offset = static_cast<uint32_t>(sizeof(Ktx2Header) + mip_levels * sizeof(Ktx2Level)),
+      .dfd_byte_length = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t)),
+      .kvd_byte_offset = 0,
+      .kvd_byte_length = 0,
+      .sgd_byte_offset = 0,
+      .sgd_byte_length = 0,
+  };
+  std::memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+
+  // the smallest level comes first, each one aligned to the texel block size and 4 bytes
+  uint64_t alignment = std::lcm(block.size, 4u);
+  std::vector<Ktx2Level> levels(mip_levels);
+  uint64_t offset = header.dfd_byte_offset + header.dfd_byte_length;
+  for (uint32_t i = mip_levels; i-- > 0;) {
+    uint64_t size = getMipOffset(i + 1) - getMipOffset(i);
+    offset = (offset + alignment - 1) / alignment * alignment;
+    levels[i] = {.byte_offset = offset, .byte_length = size, .uncompressed_byte_length = size};
+    offset += size;
+  }
+
+  std::vector<uint8_t> bytes(offset);
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  std::memcpy(bytes.data() + sizeof(header), levels.data(), levels.size() * sizeof(Ktx2Level));
+  std::memcpy(bytes.data() + header.dfd_byte_offset, dfd.data(), header.dfd_byte_length);
+  for (uint32_t i = 0; i < mip_levels; i++) {
+    std::memcpy(bytes.data() + levels[i].byte_offset, pixels.data() + getMipOffset(i),
+                levels[i].byte_length);
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to write texture " + path);
+  }
+  file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+size_t TextureData::getMipOffset(uint32_t level) const {
+  auto block = getFormatBlock(format);
+  size_t offset = 0;
+  for (uint32_t i = 0; i < level; i++) {
+    size_t blocks_x = (std::max(width >> i, 1u) + block.extent - 1) / block.extent;
+    size_t blocks_y = (std::max(height >> i, 1u) + block.extent - 1) / block.extent;
+    offset += blocks_x * blocks_y * block.size;
+  }
+  return offset;
+}
+
+Texture::Texture(const std::string& path) : Texture(TextureData::load(path)) {}
+
+Texture::Texture(const TextureData& data, bool bindless) {
+  auto& ctx = GraphicsContext::get();
+
+  // owns the data if it had to be converted
+  TextureData converted;
+  const TextureData* source = &data;
+  if (isBlockCompressed(data.format) && !supportsSampling(data.format)) {
+    converted = data.decompress();
+    source = &converted;
+  }
+  vk::Format format = source->format;
+
+  // block-compressed textures come with their mips
+  uint32_t levels = isBlockCompressed(format) ? source->mip_levels
+                                              : getMipLevelCount(data.width, data.height);
+  bool blit_mips = source->mip_levels < levels && supportsLinearBlits(format);
+  if (source->mip_levels < levels && !blit_mips) {
+    if (source != &converted) {
+      converted = data;
+    }
+    converted.generateMips();
+    source = &converted;
+  }
 
   vk::ImageCreateInfo image_info{
       .imageType = vk::ImageType::e2D,
-      .format = vk::Format::eR8G8B8A8Srgb,
-      .extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1},
-      .mipLevels = 1,
+      .format = format,
+      .extent = {data.width, data.height, 1},
+      .mipLevels = levels,
       .arrayLayers = 1,
       .samples = vk::SampleCountFlagBits::e1,
       .tiling = vk::ImageTiling::eOptimal,
-      .usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+      .usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled |
+               (blit_mips ? vk::ImageUsageFlagBits::eTransferSrc : vk::ImageUsageFlags{}),
       .sharingMode = vk::SharingMode::eExclusive,
       .initialLayout = vk::ImageLayout::eUndefined,
   };
@@ -72,76 +440,50 @@ Texture::Texture(const std::string& path, uint32_t index) {
     throw std::runtime_error("Failed to create image");
   }
 
-  ctx.executeTransient([this, &buffer, width, height](vk::CommandBuffer cmd) {
-    transistionImageLayout(cmd, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
-
-    vk::BufferImageCopy region{
-        .imageSubresource = {vk::ImageAspectFlagBits::eColor, 0, 0, 1},
-        .imageExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1},
-    };
-    cmd.copyBufferToImage(buffer.getBuffer(), image, vk::ImageLayout::eTransferDstOptimal, 1,
-                          &region);
-
-    transistionImageLayout(cmd, vk::ImageLayout::eTransferDstOptimal,
-                           vk::ImageLayout::eShaderReadOnlyOptimal);
-  });
+  // only the first level when the others are blitted from it
+  uint32_t uploaded_levels = blit_mips ? 1 : levels;
+  std::vector<vk::BufferImageCopy> regions;
+  for (uint32_t level = 0; level < uploaded_levels; level++) {
+    regions.push_back({
+        .bufferOffset = source->getMipOffset(level),
+        .imageSubresource = {vk::ImageAspectFlagBits::eColor, level, 0, 1},
+        .imageExtent = {std::max(data.width >> level, 1u), std::max(data.height >> level, 1u), 1},
+    });
+  }
+  upload_value = ctx.getUploadScheduler().uploadImage(
+      source->pixels.data(), source->getMipOffset(uploaded_levels), image, regions,
+      {vk::ImageAspectFlagBits::eColor, 0, levels, 0, 1}, blit_mips);
 
-  img_view = createImageView(ctx.getDevice(), image, vk::Format::eR8G8B8A8Srgb);
+  img_view = createImageView(ctx.getDevice(), image, format, levels);
 
-  createTextureSampler(sampler);
+  createTextureSampler(sampler, levels);
 
-  vk::DescriptorImageInfo desc_img_info{
-      .sampler = sampler,
-      .imageView = img_view,
-      .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-  };
-  vk::WriteDescriptorSet write_set{
-      .dstSet = ctx.getDescriptorSet(),
-      .dstBinding = 2,
-      .dstArrayElement = index,
-      .descriptorCount = 1,
-      .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-      .pImageInfo = &desc_img_info,
-  };
-  ctx.getDevice().updateDescriptorSets(write_set, nullptr);
+  if (bindless) {
+    handle = ctx.getBindlessRegistry().registerTexture(getDescriptorInfo());
+  }
 }
 
 Texture::~Texture() {
   auto& ctx = GraphicsContext::get();
+  if (handle.isValid()) {
+    ctx.getBindlessRegistry().release(handle);
+  }
   ctx.getDevice().destroySampler(sampler);
   ctx.getDevice().destroyImageView(img_view);
   vmaDestroyImage(ctx.getAllocator(), image, allocation);
 }
 
-void Texture::transistionImageLayout(vk::CommandBuffer cmd, vk::ImageLayout oldLayout,
-                                     vk::ImageLayout newLayout) {
-  vk::PipelineStageFlags src_stage;
-  vk::PipelineStageFlags dst_stage;
-  vk::ImageMemoryBarrier barrier{
-      .oldLayout = oldLayout,
-      .newLayout = newLayout,
-      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-      .image = image,
-      .subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1},
+vk::DescriptorImageInfo Texture::getDescriptorInfo() const {
+  return {
+      .sampler = sampler,
+      .imageView = img_view,
+      .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
   };
+}
 
-  if (oldLayout == vk::ImageLayout::eUndefined &&
-      newLayout == vk::ImageLayout::eTransferDstOptimal) {
-    barrier.srcAccessMask = vk::AccessFlagBits::eNone;
-    barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-    src_stage = vk::PipelineStageFlagBits::eTopOfPipe;
-    dst_stage = vk::PipelineStageFlagBits::eTransfer;
-  } else if (oldLayout == vk::ImageLayout::eTransferDstOptimal &&
-             newLayout == vk::ImageLayout::eShaderReadOnlyOptimal) {
-    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-    barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-    src_stage = vk::PipelineStageFlagBits::eTransfer;
-    dst_stage = vk::PipelineStageFlagBits::eFragmentShader;
-  } else {
-    throw std::runtime_error("Unsupported layout transition!");
-  }
-
-  cmd.pipelineBarrier(src_stage, dst_stage, {}, 0, nullptr, 0, nullptr, 1, &barrier);
+bool Texture::isResident() const {
+  auto& ctx = GraphicsContext::get();
+  return ctx.getAcquiredUploadValue() >= upload_value &&
+         ctx.getUploadScheduler().isComplete(upload_value);
 }
 }  // namespace TE
\ No newline at end of file
@@ -6,20 +6,59 @@
 #include <vulkan/vulkan.hpp>
 
 #include "ToyEngine/Renderer/Allocator.hpp"
+#include "ToyEngine/Renderer/BindlessRegistry.hpp"
 
 namespace TE {
+// Texels or compressed blocks of a texture, the mip levels follow each other starting with the
+// largest.
+struct TextureData {
+  vk::Format format = vk::Format::eR8G8B8A8Srgb;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t mip_levels = 1;
+  std::vector<uint8_t> pixels;
+
+  // Images are decoded to sRGB RGBA8, .ktx2 files keep their format and mip levels. The file is
+  // opened through the Vfs.
+  static TextureData load(const std::string& path);
+  // Appends the missing levels of the full mip chain of an RGBA8 texture, averaging 2x2 texels of
+  // the previous level in linear space.
+  void generateMips();
+  // Decodes block-compressed levels to RGBA8.
+  TextureData decompress() const;
+  // Encodes the levels of an RGBA8 texture to BC1, or to BC3 if any texel is translucent.
+  TextureData compress() const;
+  // Writes the levels to a .ktx2 file that load() reads back as they are, only RGBA8, BC1 and BC3
+  // are supported.
+  void save(const std::string& path) const;
+  // offset of the level in pixels
+  size_t getMipOffset(uint32_t level) const;
+};
+
 class Texture {
  public:
-  Texture(const std::string& path, uint32_t index);
+  Texture(const std::string& path);
+  // Missing levels of the full mip chain are blitted on the GPU from the first one, or generated
+  // on the CPU if the device can't blit the format with a linear filter. Block-compressed data is
+  // uploaded with the levels it has, or decoded on the CPU if the device can't sample its format.
+  // Without a bindless slot of its own the texture's descriptor can be written into another one,
+  // see TextureStreamer.
+  Texture(const TextureData& data, bool bindless = true);
   ~Texture();
 
+  // index into the global texture array in shaders
+  inline TextureHandle getHandle() const { return handle; }
+  vk::DescriptorImageInfo getDescriptorInfo() const;
+  // The upload has completed and was handed over to a frame. Textures with a slot of their own
+  // can be used right away, the frames wait for their upload on the GPU.
+  bool isResident() const;
+
  private:
   VkImage image;
   VmaAllocation allocation;
   vk::ImageView img_view;
   vk::Sampler sampler;
-
-  void transistionImageLayout(vk::CommandBuffer cmd, vk::ImageLayout oldLayout,
-                              vk::ImageLayout newLayout);
+  TextureHandle handle;
+  uint64_t upload_value = 0;
 };
-}  // namespace TE
\ No newline at end of file
+}  // namespace TE
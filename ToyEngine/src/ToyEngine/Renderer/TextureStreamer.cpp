@@ -0,0 +1,163 @@
+#include "TextureStreamer.hpp"
+
+#include "ToyEngine/Renderer/GraphicsContext.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+TextureStreamer::TextureStreamer(uint32_t thread_count) {
+  // a neutral grey, only written into the slots of other textures
+  placeholder = std::make_unique<Texture>(
+      TextureData{
+          .width = 1,
+          .height = 1,
+          .pixels = {128, 128, 128, 255},
+      },
+      false);
+
+  for (uint32_t i = 0; i < std::max(1u, thread_count); i++) {
+    loaders.emplace_back([this] { loaderLoop(); });
+  }
+}
+
+TextureStreamer::~TextureStreamer() {
+  {
+    std::lock_guard lock{mutex};
+    stopping = true;
+    queue.clear();
+  }
+  condition.notify_all();
+  for (auto& loader : loaders) {
+    loader.join();
+  }
+
+  auto& bindless = GraphicsContext::get().getBindlessRegistry();
+  for (auto& [index, entry] : entries) {
+    bindless.release(TextureHandle{index});
+  }
+}
+
+TextureHandle TextureStreamer::request(const std::string& path, int32_t priority) {
+  auto& bindless = GraphicsContext::get().getBindlessRegistry();
+  TextureHandle handle = bindless.registerTexture(placeholder->getDescriptorInfo());
+  uint64_t id = next_id++;
+  entries[handle.index] = {.id = id};
+
+  {
+    std::lock_guard lock{mutex};
+    queue.push_back({.id = id, .path = path, .handle = handle, .priority = priority});
+  }
+  condition.notify_one();
+  return handle;
+}
+
+void TextureStreamer::setPriority(TextureHandle handle, int32_t priority) {
+  auto entry = entries.find(handle.index);
+  if (entry == entries.end()) {
+    return;
+  }
+
+  std::lock_guard lock{mutex};
+  for (auto& request : queue) {
+    if (request.id == entry->second.id) {
+      request.priority = priority;
+    }
+  }
+}
+
+void TextureStreamer::cancel(TextureHandle handle) {
+  auto entry = entries.find(handle.index);
+  if (entry == entries.end()) {
+    return;
+  }
+
+  {
+    std::lock_guard lock{mutex};
+    uint64_t id = entry->second.id;
+    std::erase_if(queue, [id](const Request& request) { return request.id == id; });
+  }
+  // a texture still being decoded is retired once it arrives
+  if (entry->second.texture) {
+    retire(std::move(entry->second.texture));
+  }
+  entries.erase(entry);
+  GraphicsContext::get().getBindlessRegistry().release(handle);
+}
+
+bool TextureStreamer::isResident(TextureHandle handle) const {
+  auto entry = entries.find(handle.index);
+  return entry != entries.end() && entry->second.resident;
+}
+
+void TextureStreamer::update() {
+  std::vector<Loaded> arrived;
+  {
+    std::lock_guard lock{mutex};
+    arrived.swap(loaded);
+  }
+
+  for (auto& result : arrived) {
+    // the slot may have been cancelled and handed out again in the meantime
+    auto entry = entries.find(result.handle.index);
+    if (entry == entries.end() || entry->second.id != result.id) {
+      retire(std::move(result.texture));
+      continue;
+    }
+    entry->second.texture = std::move(result.texture);
+    uploading.push_back({.handle = result.handle, .id = result.id});
+  }
+
+  auto& bindless = GraphicsContext::get().getBindlessRegistry();
+  std::erase_if(uploading, [&](const Uploading& texture) {
+    auto entry = entries.find(texture.handle.index);
+    if (entry == entries.end() || entry->second.id != texture.id) {
+      return true;  // cancelled
+    }
+    if (!entry->second.texture->isResident()) {
+      return false;
+    }
+    bindless.update(texture.handle, entry->second.texture->getDescriptorInfo());
+    entry->second.resident = true;
+    return true;
+  });
+
+  for (auto& texture : retired) {
+    if (texture.frames > 0 && texture.texture->isResident()) {
+      texture.frames--;
+    }
+  }
+  std::erase_if(retired, [](const Retired& texture) { return texture.frames == 0; });
+}
+
+void TextureStreamer::loaderLoop() {
+  while (true) {
+    Request request;
+    {
+      std::unique_lock lock{mutex};
+      condition.wait(lock, [this] { return stopping || !queue.empty(); });
+      if (stopping) {
+        return;
+      }
+
+      auto next = std::max_element(queue.begin(), queue.end(), [](auto& a, auto& b) {
+        return a.priority < b.priority || (a.priority == b.priority && a.id > b.id);
+      });
+      request = std::move(*next);
+      queue.erase(next);
+    }
+
+    try {
+      auto texture = std::make_unique<Texture>(TextureData::load(request.path), false);
+      std::lock_guard lock{mutex};
+      loaded.push_back({.id = request.id, .handle = request.handle, .texture = std::move(texture)});
+    } catch (const std::exception& e) {
+      // the slot keeps showing the placeholder
+      LOG(e.what());
+    }
+  }
+}
+
+void TextureStreamer::retire(std::unique_ptr<Texture> texture) {
+  // frames recorded before the slot was released or the upload's acquire barrier may still use it
+  retired.push_back({.texture = std::move(texture), .frames = GraphicsContext::MAX_FRAMES_QUEUED});
+}
+}  // namespace TE
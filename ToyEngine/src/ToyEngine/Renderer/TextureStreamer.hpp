@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "ToyEngine/Renderer/BindlessRegistry.hpp"
+#include "ToyEngine/Renderer/Texture.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Loads textures in the background. A requested texture gets its bindless slot right away, the
+// slot shows a placeholder until the texture is resident. Loaders decode the images in priority
+// order on threads of their own, as a long decode taken up by a thread waiting on the job system
+// would stall the frame. The pixels are uploaded through the UploadScheduler's transfer queue.
+// Requests are made and updated from the simulation.
+class TextureStreamer {
+ public:
+  TextureStreamer(uint32_t thread_count = 1);
+  // Cancels the pending loads and waits for the ones being decoded.
+  ~TextureStreamer();
+
+  // Higher priorities are loaded first, equal ones in request order.
+  TextureHandle request(const std::string& path, int32_t priority = 0);
+  // Only affects loads that haven't started decoding.
+  void setPriority(TextureHandle handle, int32_t priority);
+  // Cancels the load or unloads the texture and releases the handle.
+  void cancel(TextureHandle handle);
+  bool isResident(TextureHandle handle) const;
+
+  // Points the slots of resident textures at them and frees cancelled ones no frame uses anymore,
+  // to be called once per frame.
+  void update();
+
+ private:
+  struct Request {
+    uint64_t id;
+    std::string path;
+    TextureHandle handle;
+    int32_t priority;
+  };
+
+  // a texture created by a loader, its upload may still be in flight
+  struct Loaded {
+    uint64_t id;
+    TextureHandle handle;
+    std::unique_ptr<Texture> texture;
+  };
+
+  struct Entry {
+    uint64_t id;
+    std::unique_ptr<Texture> texture;
+    bool resident = false;
+  };
+
+  struct Uploading {
+    TextureHandle handle;
+    uint64_t id;
+  };
+
+  struct Retired {
+    std::unique_ptr<Texture> texture;
+    uint32_t frames;
+  };
+
+  void loaderLoop();
+  void retire(std::unique_ptr<Texture> texture);
+
+  std::unique_ptr<Texture> placeholder;
+  uint64_t next_id = 0;
+  // by slot index, only touched by the simulation
+  std::unordered_map<uint32_t, Entry> entries;
+  std::vector<Uploading> uploading;
+  std::vector<Retired> retired;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<Request> queue;
+  std::vector<Loaded> loaded;
+  bool stopping = false;
+  std::vector<std::thread> loaders;
+};
+}  // namespace TE
@@ -0,0 +1,179 @@
+#include "TransformHierarchy.hpp"
+
+#include "tepch.hpp"
+
+namespace TE {
+uint32_t TransformHierarchy::add(const glm::mat4& local, uint32_t parent) {
+  uint32_t index = nodes.size();
+  uint32_t depth = parent == NO_PARENT ? 0 : depths[indices[parent]] + 1;
+
+  // appending keeps parents in front of their children, the depth order is restored lazily
+  if (!depths.empty() && depth < depths.back()) {
+    order_dirty = true;
+  }
+
+  locals.push_back(local);
+  worlds.push_back(local);
+  parents.push_back(parent == NO_PARENT ? NO_PARENT : indices[parent]);
+  depths.push_back(depth);
+  dirty.push_back(1);
+
+  uint32_t node;
+  if (!free_nodes.empty()) {
+    node = free_nodes.back();
+    free_nodes.pop_back();
+    indices[node] = index;
+    parent_nodes[node] = parent;
+  } else {
+    node = indices.size();
+    indices.push_back(index);
+    parent_nodes.push_back(parent);
+  }
+  nodes.push_back(node);
+  return node;
+}
+
+void TransformHierarchy::remove(uint32_t node) {
+  uint32_t parent = parent_nodes[node];
+  for (uint32_t child : nodes) {
+    if (parent_nodes[child] == node) {
+      parent_nodes[child] = parent;
+    }
+  }
+
+  // the last index takes the node's place, sortByDepth() restores the order
+  uint32_t index = indices[node];
+  uint32_t last = nodes.size() - 1;
+  locals[index] = locals[last];
+  worlds[index] = worlds[last];
+  nodes[index] = nodes[last];
+  indices[nodes[index]] = index;
+  locals.pop_back();
+  worlds.pop_back();
+  parents.pop_back();
+  depths.pop_back();
+  dirty.pop_back();
+  nodes.pop_back();
+
+  parent_nodes[node] = NO_PARENT;
+  free_nodes.push_back(node);
+  order_dirty = true;
+}
+
+void TransformHierarchy::setParent(uint32_t node, uint32_t parent) {
+  for (uint32_t ancestor = parent; ancestor != NO_PARENT; ancestor = parent_nodes[ancestor]) {
+    if (ancestor == node) {
+      throw std::runtime_error("Transform parent would create a cycle");
+    }
+  }
+
+  parent_nodes[node] = parent;
+  order_dirty = true;
+}
+
+void TransformHierarchy::setLocal(uint32_t node, const glm::mat4& local) {
+  uint32_t index = indices[node];
+  locals[index] = local;
+  dirty[index] = 1;
+}
+
+uint32_t TransformHierarchy::getDepth(uint32_t node) const {
+  uint32_t depth = 0;
+  for (uint32_t parent = parent_nodes[node]; parent != NO_PARENT; parent = parent_nodes[parent]) {
+    depth++;
+  }
+  return depth;
+}
+
+void TransformHierarchy::sortByDepth() {
+  std::vector<uint32_t> node_depths(indices.size());
+  for (uint32_t node : nodes) {
+    node_depths[node] = getDepth(node);
+  }
+
+  // stable, so unrelated nodes keep their relative order
+  std::vector<uint32_t> order = nodes;
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return node_depths[a] < node_depths[b];
+  });
+
+  std::vector<glm::mat4> sorted_locals(order.size());
+  for (uint32_t index = 0; index < order.size(); index++) {
+    uint32_t node = order[index];
+    sorted_locals[index] = locals[indices[node]];
+    nodes[index] = node;
+  }
+  for (uint32_t index = 0; index < order.size(); index++) {
+    indices[nodes[index]] = index;
+  }
+  for (uint32_t index = 0; index < order.size(); index++) {
+    uint32_t parent = parent_nodes[nodes[index]];
+    parents[index] = parent == NO_PARENT ? NO_PARENT : indices[parent];
+    depths[index] = node_depths[nodes[index]];
+  }
+
+  // every index may hold another node now
+  locals = std::move(sorted_locals);
+  std::fill(dirty.begin(), dirty.end(), 1);
+  order_dirty = false;
+}
+
+bool TransformHierarchy::updateNode(uint32_t index) {
+  uint32_t parent = parents[index];
+  if (parent != NO_PARENT && dirty[parent]) {
+    dirty[index] = 1;
+  }
+  if (!dirty[index]) {
+    return false;
+  }
+
+  worlds[index] = parent == NO_PARENT ? locals[index] : worlds[parent] * locals[index];
+  return true;
+}
+
+void TransformHierarchy::update(JobSystem* jobs) {
+  if (order_dirty) {
+    sortByDepth();
+  }
+
+  changed_ranges.clear();
+  auto addChanged = [&](uint32_t index) {
+    if (!changed_ranges.empty() &&
+        changed_ranges.back().first + changed_ranges.back().count == index) {
+      changed_ranges.back().count++;
+    } else {
+      changed_ranges.push_back({index, 1});
+    }
+  };
+
+  if (!jobs || nodes.size() < PARALLEL_NODES) {
+    for (uint32_t index = 0; index < nodes.size(); index++) {
+      if (updateNode(index)) {
+        addChanged(index);
+      }
+    }
+  } else {
+    for (uint32_t level = 0; level < nodes.size();) {
+      uint32_t end = std::upper_bound(depths.begin() + level, depths.end(), depths[level]) -
+                     depths.begin();
+      jobs->parallelFor(end - level, PARALLEL_BATCH_SIZE, [&](uint32_t begin, uint32_t finish) {
+        for (uint32_t index = level + begin; index < level + finish; index++) {
+          updateNode(index);
+        }
+      });
+      level = end;
+    }
+
+    // the dirty flags now mark every changed node
+    for (uint32_t index = 0; index < nodes.size(); index++) {
+      if (dirty[index]) {
+        addChanged(index);
+      }
+    }
+  }
+
+  for (auto& range : changed_ranges) {
+    std::fill_n(dirty.begin() + range.first, range.count, 0);
+  }
+}
+}  // namespace TE
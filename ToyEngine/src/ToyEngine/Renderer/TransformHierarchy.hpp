@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <span>
+
+#include "ToyEngine/Core/JobSystem.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Parent/child transforms in contiguous arrays ordered by depth, so every parent precedes its
+// children and the world matrices are computed in one linear pass. Only nodes whose local
+// transform or one of whose ancestors changed are recomputed, update() reports their indices as
+// ranges, e.g. to upload just those world matrices.
+class TransformHierarchy {
+ public:
+  static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+  struct Range {
+    uint32_t first;
+    uint32_t count;
+  };
+
+  // Returns the node id, which stays valid when the arrays are reordered. Ids of removed nodes
+  // are reused.
+  uint32_t add(const glm::mat4& local = glm::mat4(1.0f), uint32_t parent = NO_PARENT);
+  // The children of the node move to its parent, keeping their local transforms.
+  void remove(uint32_t node);
+  void setParent(uint32_t node, uint32_t parent);
+  void setLocal(uint32_t node, const glm::mat4& local);
+
+  // Recomputes the world matrices of the dirty subtrees. With a job system the nodes of each depth
+  // are updated in parallel, as they only read the level above.
+  void update(JobSystem* jobs = nullptr);
+
+  inline const glm::mat4& getLocal(uint32_t node) const { return locals[indices[node]]; }
+  // as of the last update()
+  inline const glm::mat4& getWorld(uint32_t node) const { return worlds[indices[node]]; }
+  inline uint32_t getParent(uint32_t node) const { return parent_nodes[node]; }
+
+  // Position of the node in getWorlds(), changes when the depth order is rebuilt after adding or
+  // reparenting nodes.
+  inline uint32_t getIndex(uint32_t node) const { return indices[node]; }
+  inline uint32_t getNode(uint32_t index) const { return nodes[index]; }
+  inline std::span<const glm::mat4> getWorlds() const { return worlds; }
+  // indices whose world matrix changed in the last update()
+  inline std::span<const Range> getChangedRanges() const { return changed_ranges; }
+  // number of nodes, node ids may be larger after removals
+  inline size_t size() const { return nodes.size(); }
+
+ private:
+  void sortByDepth();
+  // Returns whether the node's world matrix changed.
+  bool updateNode(uint32_t index);
+  uint32_t getDepth(uint32_t node) const;
+
+  // by index, in depth order
+  std::vector<glm::mat4> locals;
+  std::vector<glm::mat4> worlds;
+  std::vector<uint32_t> parents;  // index of the parent
+  std::vector<uint32_t> depths;
+  std::vector<uint8_t> dirty;
+  std::vector<uint32_t> nodes;  // index -> node
+
+  // by node
+  std::vector<uint32_t> indices;  // node -> index
+  std::vector<uint32_t> parent_nodes;
+  std::vector<uint32_t> free_nodes;
+
+  std::vector<Range> changed_ranges;
+  bool order_dirty = false;
+
+  static constexpr uint32_t PARALLEL_NODES = 16 * 1024;
+  static constexpr uint32_t PARALLEL_BATCH_SIZE = 1024;
+};
+}  // namespace TE
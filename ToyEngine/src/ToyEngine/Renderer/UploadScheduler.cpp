@@ -0,0 +1,289 @@
+#include "UploadScheduler.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/Helpers.hpp"
+
+namespace TE {
+namespace {
+// transfer reads cover copies of uploaded buffers, e.g. the GeometryPool's relocations
+constexpr vk::AccessFlags UPLOAD_READ_ACCESS =
+    vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eVertexAttributeRead |
+    vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eUniformRead |
+    vk::AccessFlagBits::eShaderRead;
+constexpr vk::DeviceSize STAGING_RING_SIZE = 64 * 1024 * 1024;
+// covers the texel size of all uncompressed and block-compressed formats
+constexpr vk::DeviceSize STAGING_ALIGNMENT = 16;
+constexpr vk::PipelineStageFlags UPLOAD_READ_STAGES =
+    vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eVertexInput |
+    vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader;
+}  // namespace
+
+UploadScheduler::UploadScheduler(const Device& device, const Allocator& allocator)
+    : device{device}, staging_ring{allocator.getAllocator(), STAGING_RING_SIZE} {
+  vk::CommandPoolCreateInfo pool_info{
+      .flags = vk::CommandPoolCreateFlagBits::eTransient |
+               vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+      .queueFamilyIndex = device.getTransferQueueIndex(),
+  };
+  command_pool = device.getDevice().createCommandPool(pool_info);
+
+  vk::SemaphoreTypeCreateInfo timeline_info{
+      .semaphoreType = vk::SemaphoreType::eTimeline,
+      .initialValue = 0,
+  };
+  timeline = device.getDevice().createSemaphore({.pNext = &timeline_info});
+}
+
+UploadScheduler::~UploadScheduler() {
+  wait(submitted_value);
+  device.getDevice().destroyCommandPool(command_pool);
+  device.getDevice().destroySemaphore(timeline);
+}
+
+StagingAllocation UploadScheduler::stage(const void* data, vk::DeviceSize size) {
+  std::lock_guard lock{mutex};
+  if (size <= staging_ring.getCapacity() / 4) {
+    auto allocation = staging_ring.allocate(size, STAGING_ALIGNMENT);
+    if (!allocation) {
+      // the ring is full, retire batches until there is enough space
+      if (staging_ring.hasUnfencedAllocations()) {
+        flush();
+      }
+      while (!allocation && !in_flight.empty()) {
+        wait(in_flight.front().value);
+        collect();
+        allocation = staging_ring.allocate(size, STAGING_ALIGNMENT);
+      }
+    }
+
+    if (allocation) {
+      staging_ring.write(*allocation, data, size);
+      return *allocation;
+    }
+  }
+
+  auto buffer = Buffer::createStagingBuffer(size);
+  buffer.write(data, size, 0);
+  StagingAllocation allocation{.buffer = buffer.getBuffer(), .offset = 0, .data = nullptr};
+  keepAlive(std::move(buffer));
+  return allocation;
+}
+
+void UploadScheduler::uploadBuffer(const void* data, vk::DeviceSize size, vk::Buffer dst,
+                                   vk::DeviceSize dst_offset) {
+  std::lock_guard lock{mutex};
+  auto staging = stage(data, size);
+  copyBuffer(staging.buffer, dst,
+             {.srcOffset = staging.offset, .dstOffset = dst_offset, .size = size});
+}
+
+uint64_t UploadScheduler::uploadImage(const void* data, vk::DeviceSize size, vk::Image dst,
+                                   const std::span<const vk::BufferImageCopy> regions,
+                                   const vk::ImageSubresourceRange& range, bool generate_mips) {
+  std::lock_guard lock{mutex};
+  auto staging = stage(data, size);
+
+  std::vector<vk::BufferImageCopy> staged_regions(regions.begin(), regions.end());
+  for (auto& region : staged_regions) {
+    region.bufferOffset += staging.offset;
+  }
+  return copyBufferToImage(staging.buffer, dst, staged_regions, range, generate_mips);
+}
+
+void UploadScheduler::copyBuffer(vk::Buffer src, vk::Buffer dst, const vk::BufferCopy& region) {
+  std::lock_guard lock{mutex};
+  auto cmd = getCommandBuffer();
+  cmd.copyBuffer(src, dst, region);
+
+  vk::BufferMemoryBarrier barrier{
+      .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+      .dstAccessMask = UPLOAD_READ_ACCESS,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .buffer = dst,
+      .offset = region.dstOffset,
+      .size = region.size,
+  };
+
+  if (device.hasDedicatedTransferQueue()) {
+    // queue family ownership transfer, see the Vulkan spec 7.7.4
+    barrier.srcQueueFamilyIndex = device.getTransferQueueIndex();
+    barrier.dstQueueFamilyIndex = device.getGraphicsQueueIndex();
+
+    auto release = barrier;
+    release.dstAccessMask = vk::AccessFlagBits::eNone;
+    recording.buffer_releases.push_back(release);
+
+    barrier.srcAccessMask = vk::AccessFlagBits::eNone;
+  }
+  recording.buffer_acquires.push_back(barrier);
+}
+
+uint64_t UploadScheduler::copyBufferToImage(vk::Buffer src, vk::Image dst,
+                                            const std::span<const vk::BufferImageCopy> regions,
+                                            const vk::ImageSubresourceRange& range,
+                                            bool generate_mips) {
+  std::lock_guard lock{mutex};
+  auto cmd = getCommandBuffer();
+  transitionImageLayout(cmd, dst, vk::ImageLayout::eUndefined,
+                        vk::ImageLayout::eTransferDstOptimal, range);
+  cmd.copyBufferToImage(src, dst, vk::ImageLayout::eTransferDstOptimal, regions);
+
+  vk::ImageMemoryBarrier barrier{
+      .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+      .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+      .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+      .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = dst,
+      .subresourceRange = range,
+  };
+
+  if (device.hasDedicatedTransferQueue()) {
+    barrier.srcQueueFamilyIndex = device.getTransferQueueIndex();
+    barrier.dstQueueFamilyIndex = device.getGraphicsQueueIndex();
+
+    auto release = barrier;
+    release.dstAccessMask = vk::AccessFlagBits::eNone;
+    recording.image_releases.push_back(release);
+
+    barrier.srcAccessMask = vk::AccessFlagBits::eNone;
+  }
+  recording.image_acquires.push_back(barrier);
+
+  if (generate_mips) {
+    auto extent = regions.front().imageExtent;
+    recording.mip_generations.push_back({
+        .image = dst,
+        .extent = {extent.width, extent.height},
+        .levels = range.levelCount,
+    });
+  }
+  return submitted_value + 1;
+}
+
+void UploadScheduler::keepAlive(Buffer&& buffer) {
+  std::lock_guard lock{mutex};
+  recording.staging_buffers.push_back(std::move(buffer));
+}
+
+uint64_t UploadScheduler::flush() {
+  std::lock_guard lock{mutex};
+  if (!recording.command_buffer) {
+    return submitted_value;
+  }
+
+  auto cmd = recording.command_buffer;
+  if (!recording.buffer_releases.empty() || !recording.image_releases.empty()) {
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                        vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr,
+                        recording.buffer_releases, recording.image_releases);
+  }
+  cmd.end();
+
+  uint64_t value = ++submitted_value;
+  staging_ring.fence(value);
+
+  vk::TimelineSemaphoreSubmitInfo timeline_info{
+      .signalSemaphoreValueCount = 1,
+      .pSignalSemaphoreValues = &value,
+  };
+  vk::SubmitInfo submit_info{
+      .pNext = &timeline_info,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &cmd,
+      .signalSemaphoreCount = 1,
+      .pSignalSemaphores = &timeline,
+  };
+  {
+    std::lock_guard queue_lock{device.getQueueMutex()};
+    device.getTransferQueue().submit(submit_info);
+  }
+
+  buffer_acquires.insert(buffer_acquires.end(), recording.buffer_acquires.begin(),
+                         recording.buffer_acquires.end());
+  image_acquires.insert(image_acquires.end(), recording.image_acquires.begin(),
+                        recording.image_acquires.end());
+  mip_generations.insert(mip_generations.end(), recording.mip_generations.begin(),
+                         recording.mip_generations.end());
+
+  recording.value = value;
+  recording.buffer_releases.clear();
+  recording.image_releases.clear();
+  recording.buffer_acquires.clear();
+  recording.image_acquires.clear();
+  recording.mip_generations.clear();
+  in_flight.push_back(std::move(recording));
+  recording = {};
+
+  return value;
+}
+
+uint64_t UploadScheduler::recordAcquires(vk::CommandBuffer cmd) {
+  std::lock_guard lock{mutex};
+  uint64_t value = flush();
+  if (buffer_acquires.empty() && image_acquires.empty()) {
+    return value;
+  }
+
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, UPLOAD_READ_STAGES, {}, nullptr,
+                      buffer_acquires, image_acquires);
+  buffer_acquires.clear();
+  image_acquires.clear();
+
+  for (auto& mips : mip_generations) {
+    generateMipmaps(cmd, mips.image, mips.extent, mips.levels);
+  }
+  mip_generations.clear();
+  return value;
+}
+
+void UploadScheduler::collect() {
+  std::lock_guard lock{mutex};
+  uint64_t completed = device.getDevice().getSemaphoreCounterValue(timeline);
+
+  auto end = std::find_if(in_flight.begin(), in_flight.end(),
+                          [completed](const Batch& batch) { return batch.value > completed; });
+  for (auto it = in_flight.begin(); it != end; ++it) {
+    free_command_buffers.push_back(it->command_buffer);
+  }
+  in_flight.erase(in_flight.begin(), end);
+  staging_ring.release(completed);
+}
+
+bool UploadScheduler::isComplete(uint64_t value) const {
+  return device.getDevice().getSemaphoreCounterValue(timeline) >= value;
+}
+
+void UploadScheduler::wait(uint64_t value) const {
+  vk::SemaphoreWaitInfo wait_info{
+      .semaphoreCount = 1,
+      .pSemaphores = &timeline,
+      .pValues = &value,
+  };
+  (void)device.getDevice().waitSemaphores(wait_info, UINT64_MAX);
+}
+
+vk::CommandBuffer UploadScheduler::getCommandBuffer() {
+  if (!recording.command_buffer) {
+    if (free_command_buffers.empty()) {
+      vk::CommandBufferAllocateInfo alloc_info{
+          .commandPool = command_pool,
+          .level = vk::CommandBufferLevel::ePrimary,
+          .commandBufferCount = 1,
+      };
+      recording.command_buffer = device.getDevice().allocateCommandBuffers(alloc_info)[0];
+    } else {
+      recording.command_buffer = free_command_buffers.back();
+      free_command_buffers.pop_back();
+    }
+
+    vk::CommandBufferBeginInfo begin_info{.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit};
+    recording.command_buffer.begin(begin_info);
+  }
+
+  return recording.command_buffer;
+}
+}  // namespace TE
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <mutex>
+#include <vulkan/vulkan.hpp>
+
+#include "ToyEngine/Renderer/Allocator.hpp"
+#include "ToyEngine/Renderer/Buffer.hpp"
+#include "ToyEngine/Renderer/Device.hpp"
+#include "ToyEngine/Renderer/StagingRing.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Batches buffer and image uploads into a single submission on the transfer queue. Completion is
+// tracked with a timeline semaphore that the graphics queue waits on instead of stalling the CPU.
+// Uploads may be issued from any thread.
+class UploadScheduler {
+ public:
+  UploadScheduler(const Device& device, const Allocator& allocator);
+  ~UploadScheduler();
+
+  // Copies data into staging memory that stays valid until the current batch has completed.
+  // Small uploads are sub-allocated from the staging ring, huge ones get a dedicated buffer.
+  StagingAllocation stage(const void* data, vk::DeviceSize size);
+  void uploadBuffer(const void* data, vk::DeviceSize size, vk::Buffer dst,
+                    vk::DeviceSize dst_offset);
+  // bufferOffset of the regions is relative to data. The image uploads return the timeline value
+  // of the batch they were recorded into.
+  uint64_t uploadImage(const void* data, vk::DeviceSize size, vk::Image dst,
+                       const std::span<const vk::BufferImageCopy> regions,
+                       const vk::ImageSubresourceRange& range, bool generate_mips = false);
+
+  void copyBuffer(vk::Buffer src, vk::Buffer dst, const vk::BufferCopy& region);
+  // Leaves the image in eShaderReadOnlyOptimal once the acquire barriers have been recorded. To
+  // generate the mips the regions only fill the range's first level, the others are blitted from
+  // it on the graphics queue after the acquire, so the format has to support linear blits.
+  uint64_t copyBufferToImage(vk::Buffer src, vk::Image dst,
+                             const std::span<const vk::BufferImageCopy> regions,
+                             const vk::ImageSubresourceRange& range, bool generate_mips = false);
+  // Keeps a staging buffer alive until the batch it is used in has completed.
+  void keepAlive(Buffer&& buffer);
+
+  // Submits the recorded batch and returns the timeline value it signals.
+  uint64_t flush();
+  // Submits the recorded batch and records the barriers handing all flushed uploads over to the
+  // graphics queue, followed by their mip generation. Both happen under one lock, so a batch
+  // flushed concurrently can't slip its acquires in. The submission of cmd has to wait on the
+  // returned timeline value at the eTransfer stage.
+  uint64_t recordAcquires(vk::CommandBuffer cmd);
+  // Recycles the command buffers and staging buffers of completed batches.
+  void collect();
+
+  bool isComplete(uint64_t value) const;
+  void wait(uint64_t value) const;
+
+  inline vk::Semaphore getTimeline() const { return timeline; }
+  inline uint64_t getSubmittedValue() const { return submitted_value; }
+
+ private:
+  vk::CommandBuffer getCommandBuffer();
+
+  struct MipGeneration {
+    vk::Image image;
+    vk::Extent2D extent;
+    uint32_t levels;
+  };
+
+  struct Batch {
+    vk::CommandBuffer command_buffer;
+    uint64_t value = 0;
+    std::vector<Buffer> staging_buffers;
+    std::vector<vk::BufferMemoryBarrier> buffer_releases;
+    std::vector<vk::ImageMemoryBarrier> image_releases;
+    std::vector<vk::BufferMemoryBarrier> buffer_acquires;
+    std::vector<vk::ImageMemoryBarrier> image_acquires;
+    std::vector<MipGeneration> mip_generations;
+  };
+
+  const Device& device;
+  // recursive as staging may flush the batch
+  std::recursive_mutex mutex;
+  StagingRing staging_ring;
+  vk::CommandPool command_pool;
+  vk::Semaphore timeline;
+  uint64_t submitted_value = 0;
+
+  Batch recording;
+  std::vector<Batch> in_flight;
+  std::vector<vk::CommandBuffer> free_command_buffers;
+
+  // acquire barriers of flushed batches not yet recorded on the graphics queue
+  std::vector<vk::BufferMemoryBarrier> buffer_acquires;
+  std::vector<vk::ImageMemoryBarrier> image_acquires;
+  std::vector<MipGeneration> mip_generations;
+};
+}  // namespace TE
@@ -0,0 +1,16 @@
+#include "Vertex.hpp"
+
+#include <cstddef>
+
+namespace TE {
+VertexLayout Vertex::getLayout() {
+  return {
+      .stride = sizeof(Vertex),
+      .attributes =
+          {
+              {0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, pos)},
+              {1, vk::Format::eR32G32Sfloat, offsetof(Vertex, uv)},
+          },
+  };
+}
+}  // namespace TE
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "ToyEngine/Renderer/PipelineBuilder.hpp"
+#include "tepch.hpp"
+
+namespace TE {
+// Vertex of every mesh, the layout depends on the glm configuration.
+struct Vertex {
+  glm::vec3 pos;
+  glm::vec2 uv;
+
+  // vertex input of the pipelines drawing meshes
+  static VertexLayout getLayout();
+};
+}  // namespace TE